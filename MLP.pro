@@ -9,39 +9,60 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    lib/matrixplus/s21_gemm.cc \
+    lib/matrixplus/s21_kernels.cc \
     lib/matrixplus/s21_matrix_oop.cc \
     main.cc \
+    model/checkpointer.cc \
+    model/dataset.cc \
     model/model.cc \
     model/neural_network/graph_network/graph_network.cc \
     model/neural_network/graph_network/layer.cc \
     model/neural_network/graph_network/neuron.cc \
+    model/neural_network/io/weight_file.cc \
     model/neural_network/io/weight_reader.cc \
     model/neural_network/io/weight_writer.cc \
+    model/neural_network/mapped_network/mapped_network.cc \
     model/neural_network/matrix_network/matrix_network.cc \
     model/neural_network/neural_network.cc \
+    model/neural_network/quantized_network/quantized_network.cc \
     model/neural_network/utility.cc \
     model/reader/csv_reader.cc \
+    model/reader/dataset_cache.cc \
+    model/reader/mapped_file.cc \
+    model/thread_pool.cc \
     view/main_window.cc \
     view/scribblearea/scribblearea.cc \
     view/qcustomplot/qcustomplot.cc
 
 HEADERS += \
     controller/controller.h \
+    lib/matrixplus/s21_gemm.h \
+    lib/matrixplus/s21_kernels.h \
     lib/matrixplus/s21_matrix_oop.h \
+    model/checkpointer.h \
     model/configuration.h \
+    model/dataset.h \
     model/image.h \
+    model/io_util.h \
     model/model.h \
     model/neural_network/graph_network/graph_network.h \
     model/neural_network/graph_network/layer.h \
     model/neural_network/graph_network/neuron.h \
+    model/neural_network/io/weight_file.h \
     model/neural_network/io/weight_reader.h \
     model/neural_network/io/weight_writer.h \
+    model/neural_network/mapped_network/mapped_network.h \
     model/neural_network/matrix_network/matrix_network.h \
     model/neural_network/network_interface.h \
     model/neural_network/neural_network.h \
+    model/neural_network/quantized_network/quantized_network.h \
     model/neural_network/utility.h \
     model/reader/base_file_reader.h \
     model/reader/csv_reader.h \
+    model/reader/dataset_cache.h \
+    model/reader/mapped_file.h \
+    model/thread_pool.h \
     view/main_window.h \
     view/scribblearea/scribblearea.h \
     view/qcustomplot/qcustomplot.h    
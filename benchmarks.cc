@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <chrono>  // NOLINT [build/c++11]
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "model/model.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const std::size_t kSyntheticImages = 2000;
+const std::size_t kRuns = 2;
+
+double SecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void RandomFill(s21::Matrix* m, std::mt19937* engine) {
+  std::uniform_real_distribution<double> distr(-1, 1);
+  for (std::size_t i = 0; i < m->GetSize(); i++) m->Data()[i] = distr(*engine);
+}
+
+// Textbook i-j-k product the blocked kernel is measured against.
+s21::Matrix NaiveProduct(const s21::Matrix& a, const s21::Matrix& b) {
+  s21::Matrix c(a.GetRows(), b.GetColumns());
+  for (std::size_t i = 0; i < a.GetRows(); i++)
+    for (std::size_t j = 0; j < b.GetColumns(); j++)
+      for (std::size_t k = 0; k < a.GetColumns(); k++)
+        c.Data()[i * c.GetStride() + j] +=
+            a.Data()[i * a.GetStride() + k] * b.Data()[k * b.GetStride() + j];
+  return c;
+}
+
+void BenchmarkGemm() {
+  std::mt19937 engine(21);
+  std::printf("%-24s %12s %12s\n", "gemm (GFLOP/s)", "naive", "s21::Matrix");
+  for (std::size_t size : {64, 140, 256, 512, 784}) {
+    s21::Matrix a(size, size), b(size, size);
+    RandomFill(&a, &engine);
+    RandomFill(&b, &engine);
+    const double flops = 2. * static_cast<double>(size * size * size);
+
+    auto start = Clock::now();
+    s21::Matrix naive = NaiveProduct(a, b);
+    double naive_time = SecondsSince(start);
+
+    start = Clock::now();
+    s21::Matrix blocked = a * b;
+    double blocked_time = SecondsSince(start);
+
+    if (!(naive == blocked)) std::printf("  result mismatch at %zu\n", size);
+    std::printf("%-24zu %12.2f %12.2f\n", size, flops / naive_time * 1e-9,
+                flops / blocked_time * 1e-9);
+  }
+}
+
+// y = A * x over a matrix well past the caches, so the time is dominated by
+// streaming A from memory and float should take about half as long.
+template <typename T>
+double GemvSeconds(std::size_t rows, std::size_t cols, std::size_t repeats) {
+  std::vector<T> a(rows * cols), x(cols), y(rows);
+  std::mt19937 engine(21);
+  std::uniform_real_distribution<double> distr(-1, 1);
+  for (T& v : a) v = static_cast<T>(distr(engine));
+  for (T& v : x) v = static_cast<T>(distr(engine));
+  s21::kernels::Gemv(rows, cols, a.data(), cols, x.data(), y.data());
+
+  auto start = Clock::now();
+  for (std::size_t r = 0; r < repeats; r++) {
+    s21::kernels::Gemv(rows, cols, a.data(), cols, x.data(), y.data());
+  }
+  return SecondsSince(start) / static_cast<double>(repeats);
+}
+
+double GemvS8Seconds(std::size_t rows, std::size_t cols,
+                     std::size_t repeats) {
+  std::vector<std::int8_t> a(rows * cols);
+  std::vector<std::uint8_t> x(cols);
+  std::vector<std::int32_t> y(rows);
+  std::mt19937 engine(21);
+  std::uniform_int_distribution<int> distr(-127, 127);
+  for (std::int8_t& v : a) v = static_cast<std::int8_t>(distr(engine));
+  for (std::uint8_t& v : x) v = static_cast<std::uint8_t>(distr(engine) & 127);
+  s21::kernels::GemvS8(rows, cols, a.data(), cols, x.data(), y.data());
+
+  auto start = Clock::now();
+  for (std::size_t r = 0; r < repeats; r++) {
+    s21::kernels::GemvS8(rows, cols, a.data(), cols, x.data(), y.data());
+  }
+  return SecondsSince(start) / static_cast<double>(repeats);
+}
+
+void BenchmarkGemv() {
+  std::printf("\n%-24s %12s %12s %12s\n", "gemv (ms)", "double", "float",
+              "int8");
+  for (std::size_t size : {784, 4096}) {
+    const double dp = GemvSeconds<double>(size, size, 20);
+    const double sp = GemvSeconds<float>(size, size, 20);
+    const double s8 = GemvS8Seconds(size, size, 20);
+    std::printf("%-24zu %12.3f %12.3f %12.3f\n", size, dp * 1e3, sp * 1e3,
+                s8 * 1e3);
+  }
+}
+
+// Writes a deterministic EMNIST-shaped CSV: every letter is a fixed stroke
+// pattern plus seeded noise, so the network has something to learn and every
+// run sees the same bytes.
+std::string WriteSyntheticDataset(const std::string& filename,
+                                  std::size_t count, unsigned seed) {
+  std::mt19937 engine(seed);
+  std::uniform_int_distribution<int> noise(0, 40);
+  std::ofstream file(filename);
+  for (std::size_t n = 0; n < count; n++) {
+    int label = static_cast<int>(n % 26) + 1;
+    file << label;
+    for (int i = 0; i < s21::Image::kSizeInPx; i++) {
+      int pixel = (i * 7 + label * 31) % 97 < 30 ? 200 : 0;
+      file << ',' << pixel + noise(engine);
+    }
+    file << '\n';
+  }
+  return filename;
+}
+
+void BenchmarkTraining(const std::string& train_file,
+                       const std::string& test_file) {
+  s21::CsvReader reader;
+  auto start = Clock::now();
+  auto train = reader.Read(train_file);
+  auto test = reader.Read(test_file);
+  std::printf("\ndataset load: %.3f s (%zu train, %zu test images)\n",
+              SecondsSince(start), train.size(), test.size());
+
+  for (auto precision : {s21::Precision::kDouble, s21::Precision::kFloat}) {
+    for (auto type : {s21::NetworkType::kMatrix, s21::NetworkType::kGraph}) {
+      double total = 0;
+      double accuracy = 0;
+      for (std::size_t run = 0; run < kRuns; run++) {
+        s21::NeuralNetwork network(type, s21::NetworkSettings(), precision);
+        start = Clock::now();
+        network.Train(train, 1);
+        accuracy += network.Test(test, 1).accuracy;
+        total += SecondsSince(start);
+      }
+      std::printf(
+          "%-18s %-6s %.3f s per run (1 epoch + test), mean accuracy %.3f\n",
+          type == s21::NetworkType::kMatrix ? "matrix perceptron"
+                                            : "graph perceptron",
+          precision == s21::Precision::kFloat ? "float" : "double",
+          total / kRuns, accuracy / kRuns);
+    }
+  }
+}
+
+// p50 and p99 of single-image Infer calls over |rounds| passes through
+// |data|. This is what the letter recognizer pays per stroke on the UI
+// thread.
+std::pair<double, double> InferLatency(s21::NeuralNetwork* network,
+                                       const s21::Dataset& data,
+                                       std::size_t rounds) {
+  std::vector<double> seconds;
+  seconds.reserve(rounds * data.size());
+  network->Infer(data[0].Pixels(), data[0].GetSize());
+  for (std::size_t r = 0; r < rounds; r++) {
+    for (std::size_t i = 0; i < data.size(); i++) {
+      auto start = Clock::now();
+      network->Infer(data[i].Pixels(), data[i].GetSize());
+      seconds.push_back(SecondsSince(start));
+    }
+  }
+  std::sort(seconds.begin(), seconds.end());
+  return {seconds[seconds.size() / 2], seconds[seconds.size() * 99 / 100]};
+}
+
+void BenchmarkInference(const std::string& train_file,
+                        const std::string& test_file) {
+  s21::CsvReader reader;
+  auto train = reader.Read(train_file);
+  auto test = reader.Read(test_file);
+  s21::utility::SeedRandom(21);
+  s21::NeuralNetwork network(s21::NetworkType::kMatrix,
+                             s21::NetworkSettings());
+  network.Train(train, 1);
+  s21::NeuralNetwork single(s21::NetworkType::kMatrix, s21::NetworkSettings(),
+                            s21::Precision::kFloat);
+  single.SetWeights(network.GetWeights());
+
+  const std::string fp64 = "/tmp/s21_benchmark_fp64.bin";
+  const std::string int8 = "/tmp/s21_benchmark_int8.bin";
+  s21::WeightWriter::Write(fp64, network.GetWeights(), network.GetSettings());
+  s21::QuantizedNetwork::Quantize(network.GetWeights(),
+                                  network.GetSettings(), test, 500)
+      .Save(int8);
+  s21::NeuralNetwork quantized(std::make_shared<s21::WeightFile>(int8));
+
+  std::printf("\n%-24s %12s %12s\n", "quantization", "double", "int8");
+  std::printf("%-24s %12.3f %12.3f\n", "accuracy",
+              network.Test(test, 1).accuracy,
+              quantized.Test(test, 1).accuracy);
+  std::printf("%-24s %12zu %12zu\n", "file size (KiB)",
+              s21::MappedFile(fp64).Size() / 1024,
+              s21::MappedFile(int8).Size() / 1024);
+  std::remove(fp64.c_str());
+  std::remove(int8.c_str());
+
+  std::printf("\n%-24s %12s %12s\n", "infer latency (us)", "p50", "p99");
+  const std::pair<const char*, s21::NeuralNetwork*> networks[] = {
+      {"double", &network}, {"float", &single}, {"int8", &quantized}};
+  for (const auto& [name, net] : networks) {
+    auto [p50, p99] = InferLatency(net, test, 10);
+    std::printf("%-24s %12.1f %12.1f\n", name, p50 * 1e6, p99 * 1e6);
+  }
+}
+
+}  // namespace
+
+// Usage: benchmark [train.csv test.csv]. Without arguments a seeded synthetic
+// dataset is generated so that numbers are comparable between machines and
+// commits.
+int main(int argc, char* argv[]) {
+  std::printf("kernels: %s\n", s21::kernels::InstructionSetName(
+                                   s21::kernels::GetInstructionSet()));
+  BenchmarkGemm();
+  BenchmarkGemv();
+
+  if (argc == 3) {
+    BenchmarkTraining(argv[1], argv[2]);
+    BenchmarkInference(argv[1], argv[2]);
+  } else {
+    std::string train = WriteSyntheticDataset(
+        "/tmp/s21_benchmark_train.csv", kSyntheticImages, 1);
+    std::string test = WriteSyntheticDataset("/tmp/s21_benchmark_test.csv",
+                                             kSyntheticImages / 4, 2);
+    BenchmarkTraining(train, test);
+    BenchmarkInference(train, test);
+    std::remove(train.c_str());
+    std::remove(test.c_str());
+  }
+  return 0;
+}
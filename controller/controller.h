@@ -54,11 +54,13 @@ class Controller {
              std::function<void(NetworkTestMetrics, std::size_t)>
                  test_end_callback = nullptr,
              std::function<void()> end_callback = nullptr,
+             std::function<void(std::size_t, double)> throughput_callback =
+                 nullptr,
              std::function<void(const std::string&)> error_callback = nullptr) {
     try {
       model_->Train(start_callback, epoch_progress_callback, epoch_end_callback,
                     test_start_callback, test_progress_callback,
-                    test_end_callback, end_callback);
+                    test_end_callback, end_callback, throughput_callback);
     } catch (const std::runtime_error& e) {
       if (error_callback) error_callback(e.what());
     }
@@ -66,9 +68,12 @@ class Controller {
 
   void StopTrain() { model_->StopTrain(); }
 
+  // summary_callback is only called in cross-validation mode.
   void Test(std::function<void()> start_callback = nullptr,
             std::function<void(std::size_t)> progress_callback = nullptr,
             std::function<void(NetworkTestMetrics)> end_callback = nullptr,
+            std::function<void(const CrossValidationMetrics&)>
+                summary_callback = nullptr,
             std::function<void(const std::string&)> error_callback = nullptr) {
     try {
       switch (GetConfiguration().GetTestType()) {
@@ -76,7 +81,7 @@ class Controller {
           model_->TrainCrossValidation(GetConfiguration().GetEpochs(),
                                        GetConfiguration().GetNumberOfGroups(),
                                        start_callback, progress_callback,
-                                       end_callback);
+                                       end_callback, summary_callback);
           break;
         case Configuration::TestType::kWeight:
           model_->Test(GetConfiguration().GetSelectionPart(), start_callback,
@@ -90,7 +95,20 @@ class Controller {
 
   void StopTest() { model_->StopTest(); }
 
-  char AnalyzeRawImage(const std::vector<double>& data) {
+  void Quantize(
+      const std::string& filename, std::size_t calibration_samples,
+      std::function<void(NetworkTestMetrics, NetworkTestMetrics)>
+          success_callback = nullptr,
+      std::function<void(const std::string&)> error_callback = nullptr) {
+    try {
+      model_->Quantize(filename, calibration_samples, success_callback,
+                       error_callback);
+    } catch (const std::runtime_error& e) {
+      if (error_callback) error_callback(e.what());
+    }
+  }
+
+  char AnalyzeRawImage(const std::vector<std::uint8_t>& data) {
     return model_->AnalyzeRawImage(data);
   }
 
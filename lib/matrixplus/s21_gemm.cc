@@ -0,0 +1,266 @@
+#include "s21_gemm.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define S21_GEMM_X86
+#include <immintrin.h>
+#endif
+
+namespace s21::kernels {
+
+namespace {
+
+// Micro-tile held in registers by the micro-kernel: kMr rows of one cache
+// line each.
+constexpr std::size_t kMr = 4;
+template <typename T>
+constexpr std::size_t kNr = 64 / sizeof(T);
+
+// Panel sizes: a kKc x kNr sliver of B stays in L1, a kMc x kKc block of A in
+// L2 and a kKc x kNc panel of B in L3.
+constexpr std::size_t kMc = 128;
+constexpr std::size_t kKc = 256;
+constexpr std::size_t kNc = 1024;
+
+// Copies an r x c block of op(M) starting at (row, col) into |packed|, where
+// element (i, j) of the block lands at packed[j * width + i]. Source rows or
+// columns are always read contiguously; rows past r are zero-filled up to
+// |width|.
+template <typename T>
+void PackSliver(Transpose trans, const T* m, std::size_t ld,
+                std::size_t row, std::size_t col, std::size_t r, std::size_t c,
+                std::size_t width, T scale, T* packed) {
+  if (trans == Transpose::kNo) {
+    // op(M)(row + i, col + j) = m[(row + i) * ld + col + j]
+    for (std::size_t i = 0; i < r; i++) {
+      const T* src = m + (row + i) * ld + col;
+      for (std::size_t j = 0; j < c; j++) {
+        packed[j * width + i] = scale * src[j];
+      }
+    }
+  } else {
+    // op(M)(row + i, col + j) = m[(col + j) * ld + row + i]
+    for (std::size_t j = 0; j < c; j++) {
+      const T* src = m + (col + j) * ld + row;
+      for (std::size_t i = 0; i < r; i++) {
+        packed[j * width + i] = scale * src[i];
+      }
+    }
+  }
+  for (std::size_t j = 0; j < c; j++) {
+    for (std::size_t i = r; i < width; i++) packed[j * width + i] = 0;
+  }
+}
+
+// Packs the mc x kc block of alpha * op(A) starting at (row, col) into kMr-row
+// slivers, k-major inside each sliver. Rows past mc are zero-filled so the
+// micro-kernel never needs an edge case on the read side.
+template <typename T>
+void PackA(Transpose trans, const T* a, std::size_t lda, std::size_t row,
+           std::size_t col, std::size_t mc, std::size_t kc, T alpha,
+           T* packed) {
+  for (std::size_t ir = 0; ir < mc; ir += kMr) {
+    PackSliver(trans, a, lda, row + ir, col, std::min(kMr, mc - ir), kc, kMr,
+               alpha, packed + ir * kc);
+  }
+}
+
+// Packs the kc x nc block of op(B) starting at (row, col) into kNr-column
+// slivers, k-major inside each sliver, zero-filling columns past nc. The
+// sliver is op(B)^T, so the transpose flag flips.
+template <typename T>
+void PackB(Transpose trans, const T* b, std::size_t ldb, std::size_t row,
+           std::size_t col, std::size_t kc, std::size_t nc, T* packed) {
+  const Transpose flipped =
+      trans == Transpose::kNo ? Transpose::kYes : Transpose::kNo;
+  for (std::size_t jr = 0; jr < nc; jr += kNr<T>) {
+    PackSliver(flipped, b, ldb, col + jr, row, std::min(kNr<T>, nc - jr), kc,
+               kNr<T>, T(1), packed + jr * kc);
+  }
+}
+
+// C[mr x nr] += A_sliver * B_sliver over kc.
+template <typename T>
+void MicroKernel(std::size_t kc, const T* a, const T* b, T* c,
+                 std::size_t ldc, std::size_t mr, std::size_t nr) {
+  T acc[kMr][kNr<T>] = {};
+  for (std::size_t p = 0; p < kc; p++) {
+    for (std::size_t r = 0; r < kMr; r++) {
+      const T a_r = a[r];
+      for (std::size_t j = 0; j < kNr<T>; j++) {
+        acc[r][j] += a_r * b[j];
+      }
+    }
+    a += kMr;
+    b += kNr<T>;
+  }
+  for (std::size_t r = 0; r < mr; r++) {
+    for (std::size_t j = 0; j < nr; j++) {
+      c[r * ldc + j] += acc[r][j];
+    }
+  }
+}
+
+#ifdef S21_GEMM_X86
+// Same contract as MicroKernel with the 4 x 8 tile held in eight ymm
+// accumulators. Written out by hand: at -O2 a loop over the rows would keep
+// the accumulators in memory.
+__attribute__((target("avx2,fma"))) void MicroKernelAvx2(
+    std::size_t kc, const double* a, const double* b, double* c,
+    std::size_t ldc, std::size_t mr, std::size_t nr) {
+  __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+  __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+  __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+  __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+  for (std::size_t p = 0; p < kc; p++) {
+    const __m256d b0 = _mm256_loadu_pd(b);
+    const __m256d b1 = _mm256_loadu_pd(b + 4);
+    __m256d a_r = _mm256_broadcast_sd(a);
+    c00 = _mm256_fmadd_pd(a_r, b0, c00);
+    c01 = _mm256_fmadd_pd(a_r, b1, c01);
+    a_r = _mm256_broadcast_sd(a + 1);
+    c10 = _mm256_fmadd_pd(a_r, b0, c10);
+    c11 = _mm256_fmadd_pd(a_r, b1, c11);
+    a_r = _mm256_broadcast_sd(a + 2);
+    c20 = _mm256_fmadd_pd(a_r, b0, c20);
+    c21 = _mm256_fmadd_pd(a_r, b1, c21);
+    a_r = _mm256_broadcast_sd(a + 3);
+    c30 = _mm256_fmadd_pd(a_r, b0, c30);
+    c31 = _mm256_fmadd_pd(a_r, b1, c31);
+    a += kMr;
+    b += kNr<double>;
+  }
+  double tile[kMr][kNr<double>];
+  _mm256_storeu_pd(tile[0], c00);
+  _mm256_storeu_pd(tile[0] + 4, c01);
+  _mm256_storeu_pd(tile[1], c10);
+  _mm256_storeu_pd(tile[1] + 4, c11);
+  _mm256_storeu_pd(tile[2], c20);
+  _mm256_storeu_pd(tile[2] + 4, c21);
+  _mm256_storeu_pd(tile[3], c30);
+  _mm256_storeu_pd(tile[3] + 4, c31);
+  for (std::size_t r = 0; r < mr; r++) {
+    for (std::size_t j = 0; j < nr; j++) c[r * ldc + j] += tile[r][j];
+  }
+}
+
+// The float tile is 4 x 16, so each row is again two ymm registers.
+__attribute__((target("avx2,fma"))) void MicroKernelAvx2(
+    std::size_t kc, const float* a, const float* b, float* c, std::size_t ldc,
+    std::size_t mr, std::size_t nr) {
+  __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+  __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+  __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+  __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+  for (std::size_t p = 0; p < kc; p++) {
+    const __m256 b0 = _mm256_loadu_ps(b);
+    const __m256 b1 = _mm256_loadu_ps(b + 8);
+    __m256 a_r = _mm256_broadcast_ss(a);
+    c00 = _mm256_fmadd_ps(a_r, b0, c00);
+    c01 = _mm256_fmadd_ps(a_r, b1, c01);
+    a_r = _mm256_broadcast_ss(a + 1);
+    c10 = _mm256_fmadd_ps(a_r, b0, c10);
+    c11 = _mm256_fmadd_ps(a_r, b1, c11);
+    a_r = _mm256_broadcast_ss(a + 2);
+    c20 = _mm256_fmadd_ps(a_r, b0, c20);
+    c21 = _mm256_fmadd_ps(a_r, b1, c21);
+    a_r = _mm256_broadcast_ss(a + 3);
+    c30 = _mm256_fmadd_ps(a_r, b0, c30);
+    c31 = _mm256_fmadd_ps(a_r, b1, c31);
+    a += kMr;
+    b += kNr<float>;
+  }
+  float tile[kMr][kNr<float>];
+  _mm256_storeu_ps(tile[0], c00);
+  _mm256_storeu_ps(tile[0] + 8, c01);
+  _mm256_storeu_ps(tile[1], c10);
+  _mm256_storeu_ps(tile[1] + 8, c11);
+  _mm256_storeu_ps(tile[2], c20);
+  _mm256_storeu_ps(tile[2] + 8, c21);
+  _mm256_storeu_ps(tile[3], c30);
+  _mm256_storeu_ps(tile[3] + 8, c31);
+  for (std::size_t r = 0; r < mr; r++) {
+    for (std::size_t j = 0; j < nr; j++) c[r * ldc + j] += tile[r][j];
+  }
+}
+#endif  // S21_GEMM_X86
+
+template <typename T>
+using MicroKernelFunction = void (*)(std::size_t, const T*, const T*, T*,
+                                     std::size_t, std::size_t, std::size_t);
+
+template <typename T>
+MicroKernelFunction<T> SelectMicroKernel() {
+#ifdef S21_GEMM_X86
+  if (static_cast<int>(GetInstructionSet()) >=
+      static_cast<int>(InstructionSet::kAvx2)) {
+    return MicroKernelAvx2;
+  }
+#endif
+  return MicroKernel<T>;
+}
+
+template <typename T>
+void Scale(std::size_t m, std::size_t n, T beta, T* c, std::size_t ldc) {
+  if (beta == 1) return;
+  for (std::size_t i = 0; i < m; i++) {
+    T* row = c + i * ldc;
+    if (beta == 0) {
+      std::fill(row, row + n, T(0));
+    } else {
+      for (std::size_t j = 0; j < n; j++) row[j] *= beta;
+    }
+  }
+}
+
+template <typename T>
+void GemmImpl(Transpose trans_a, Transpose trans_b, std::size_t m,
+              std::size_t n, std::size_t k, T alpha, const T* a,
+              std::size_t lda, const T* b, std::size_t ldb, T beta, T* c,
+              std::size_t ldc) {
+  Scale(m, n, beta, c, ldc);
+  if (m == 0 || n == 0 || k == 0 || alpha == 0) return;
+
+  const MicroKernelFunction<T> micro_kernel = SelectMicroKernel<T>();
+  thread_local std::vector<T> packed_a(kMc * kKc);
+  thread_local std::vector<T> packed_b(kKc * kNc);
+
+  for (std::size_t jc = 0; jc < n; jc += kNc) {
+    const std::size_t nc = std::min(kNc, n - jc);
+    for (std::size_t pc = 0; pc < k; pc += kKc) {
+      const std::size_t kc = std::min(kKc, k - pc);
+      PackB(trans_b, b, ldb, pc, jc, kc, nc, packed_b.data());
+
+      for (std::size_t ic = 0; ic < m; ic += kMc) {
+        const std::size_t mc = std::min(kMc, m - ic);
+        PackA(trans_a, a, lda, ic, pc, mc, kc, alpha, packed_a.data());
+
+        for (std::size_t jr = 0; jr < nc; jr += kNr<T>) {
+          for (std::size_t ir = 0; ir < mc; ir += kMr) {
+            micro_kernel(kc, packed_a.data() + ir * kc,
+                         packed_b.data() + jr * kc,
+                         c + (ic + ir) * ldc + jc + jr, ldc,
+                         std::min(kMr, mc - ir), std::min(kNr<T>, nc - jr));
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+void Gemm(Transpose trans_a, Transpose trans_b, std::size_t m, std::size_t n,
+          std::size_t k, double alpha, const double* a, std::size_t lda,
+          const double* b, std::size_t ldb, double beta, double* c,
+          std::size_t ldc) {
+  GemmImpl(trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+void Gemm(Transpose trans_a, Transpose trans_b, std::size_t m, std::size_t n,
+          std::size_t k, float alpha, const float* a, std::size_t lda,
+          const float* b, std::size_t ldb, float beta, float* c,
+          std::size_t ldc) {
+  GemmImpl(trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+}  // namespace s21::kernels
@@ -0,0 +1,30 @@
+#ifndef SRC_LIB_MATRIXPLUS_S21_GEMM_H_
+#define SRC_LIB_MATRIXPLUS_S21_GEMM_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "s21_kernels.h"
+
+namespace s21::kernels {
+
+enum class Transpose { kNo, kYes };
+
+// C = alpha * op(A) * op(B) + beta * C for row-major matrices, where op(A) is
+// m x k, op(B) is k x n and C is m x n. The operands are split into panels
+// that fit L2 (A) and L1 (B), packed into contiguous buffers and multiplied by
+// a kMr x kNr register-tiled micro-kernel (AVX2+FMA when the CPU has it). The
+// float overload uses the same blocking with twice as many columns per tile.
+void Gemm(Transpose trans_a, Transpose trans_b, std::size_t m, std::size_t n,
+          std::size_t k, double alpha, const double* a, std::size_t lda,
+          const double* b, std::size_t ldb, double beta, double* c,
+          std::size_t ldc);
+void Gemm(Transpose trans_a, Transpose trans_b, std::size_t m, std::size_t n,
+          std::size_t k, float alpha, const float* a, std::size_t lda,
+          const float* b, std::size_t ldb, float beta, float* c,
+          std::size_t ldc);
+
+}  // namespace s21::kernels
+
+#endif  // SRC_LIB_MATRIXPLUS_S21_GEMM_H_
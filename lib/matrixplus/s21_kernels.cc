@@ -0,0 +1,1183 @@
+#include "s21_kernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define S21_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace s21::kernels {
+
+namespace {
+
+struct KernelTable {
+  InstructionSet set;
+  double (*dot)(std::size_t, const double*, const double*);
+  void (*axpy)(std::size_t, double, const double*, double*);
+  void (*gemv)(std::size_t, std::size_t, const double*, std::size_t,
+               const double*, double*);
+  void (*scale_bytes)(std::size_t, double, const std::uint8_t*, double*);
+  void (*mul)(std::size_t, const double*, double*);
+  void (*sigmoid)(std::size_t, const double*, double*);
+  void (*mul_sigmoid_derivative)(std::size_t, const double*, double*);
+};
+
+/* Scalar */
+
+double DotScalar(std::size_t n, const double* x, const double* y) {
+  double sum = 0;
+  for (std::size_t i = 0; i < n; i++) sum += x[i] * y[i];
+  return sum;
+}
+
+void AxpyScalar(std::size_t n, double alpha, const double* x, double* y) {
+  for (std::size_t i = 0; i < n; i++) y[i] += alpha * x[i];
+}
+
+void GemvScalar(std::size_t m, std::size_t n, const double* a,
+                std::size_t lda, const double* x, double* y) {
+  for (std::size_t i = 0; i < m; i++) y[i] = DotScalar(n, a + i * lda, x);
+}
+
+void ScaleBytesScalar(std::size_t n, double alpha, const std::uint8_t* x,
+                      double* y) {
+  for (std::size_t i = 0; i < n; i++) y[i] = alpha * x[i];
+}
+
+void MulScalar(std::size_t n, const double* x, double* y) {
+  for (std::size_t i = 0; i < n; i++) y[i] *= x[i];
+}
+
+void SigmoidScalar(std::size_t n, const double* x, double* y) {
+  for (std::size_t i = 0; i < n; i++) y[i] = 1.0 / (1.0 + std::exp(-x[i]));
+}
+
+void MulSigmoidDerivativeScalar(std::size_t n, const double* y, double* e) {
+  for (std::size_t i = 0; i < n; i++) e[i] *= y[i] * (1.0 - y[i]);
+}
+
+constexpr KernelTable kScalarTable = {
+    InstructionSet::kScalar, DotScalar,     AxpyScalar,
+    GemvScalar,              ScaleBytesScalar, MulScalar,
+    SigmoidScalar,           MulSigmoidDerivativeScalar};
+
+/* Single precision. The float kernels mirror the double ones with twice the
+   lanes per register; SSE4.2 runs the scalar versions. */
+
+struct FloatKernelTable {
+  float (*dot)(std::size_t, const float*, const float*);
+  void (*axpy)(std::size_t, float, const float*, float*);
+  void (*gemv)(std::size_t, std::size_t, const float*, std::size_t,
+               const float*, float*);
+  void (*scale_bytes)(std::size_t, float, const std::uint8_t*, float*);
+  void (*mul)(std::size_t, const float*, float*);
+  void (*sigmoid)(std::size_t, const float*, float*);
+  void (*mul_sigmoid_derivative)(std::size_t, const float*, float*);
+};
+
+float DotScalarFloat(std::size_t n, const float* x, const float* y) {
+  float sum = 0;
+  for (std::size_t i = 0; i < n; i++) sum += x[i] * y[i];
+  return sum;
+}
+
+void AxpyScalarFloat(std::size_t n, float alpha, const float* x, float* y) {
+  for (std::size_t i = 0; i < n; i++) y[i] += alpha * x[i];
+}
+
+void GemvScalarFloat(std::size_t m, std::size_t n, const float* a,
+                     std::size_t lda, const float* x, float* y) {
+  for (std::size_t i = 0; i < m; i++) y[i] = DotScalarFloat(n, a + i * lda, x);
+}
+
+void ScaleBytesScalarFloat(std::size_t n, float alpha, const std::uint8_t* x,
+                           float* y) {
+  for (std::size_t i = 0; i < n; i++) y[i] = alpha * x[i];
+}
+
+void MulScalarFloat(std::size_t n, const float* x, float* y) {
+  for (std::size_t i = 0; i < n; i++) y[i] *= x[i];
+}
+
+void SigmoidScalarFloat(std::size_t n, const float* x, float* y) {
+  for (std::size_t i = 0; i < n; i++) y[i] = 1.0f / (1.0f + std::exp(-x[i]));
+}
+
+void MulSigmoidDerivativeScalarFloat(std::size_t n, const float* y, float* e) {
+  for (std::size_t i = 0; i < n; i++) e[i] *= y[i] * (1.0f - y[i]);
+}
+
+constexpr FloatKernelTable kScalarFloatTable = {
+    DotScalarFloat,        AxpyScalarFloat, GemvScalarFloat,
+    ScaleBytesScalarFloat, MulScalarFloat,  SigmoidScalarFloat,
+    MulSigmoidDerivativeScalarFloat};
+
+/* 8-bit integer */
+
+using GemvS8Kernel = void (*)(std::size_t, std::size_t, const std::int8_t*,
+                              std::size_t, const std::uint8_t*,
+                              std::int32_t*);
+
+void GemvS8Scalar(std::size_t m, std::size_t n, const std::int8_t* a,
+                  std::size_t lda, const std::uint8_t* x, std::int32_t* y) {
+  for (std::size_t i = 0; i < m; i++) {
+    const std::int8_t* row = a + i * lda;
+    std::int32_t sum = 0;
+    for (std::size_t j = 0; j < n; j++) sum += row[j] * x[j];
+    y[i] = sum;
+  }
+}
+
+#ifdef S21_KERNELS_X86
+
+// exp(x) = 2^k * exp(r) with k = round(x / ln 2) and |r| <= ln(2) / 2. exp(r)
+// is a Taylor polynomial of degree 11, whose truncation error r^12 / 12! stays
+// below 7e-15 on that interval. Adding kRoundMagic (1.5 * 2^52) rounds x / ln 2
+// to an integer that can be read straight from the low mantissa bits.
+constexpr double kExpMin = -708;
+constexpr double kExpMax = 708;
+constexpr double kLog2e = 1.4426950408889634;
+constexpr double kLn2Hi = 6.93145751953125e-1;
+constexpr double kLn2Lo = 1.42860682030941723212e-6;
+constexpr double kRoundMagic = 6755399441055744.0;
+constexpr std::size_t kExpDegree = 11;
+constexpr double kExpCoefficients[kExpDegree + 1] = {
+    1.0 / 39916800, 1.0 / 3628800, 1.0 / 362880, 1.0 / 40320,
+    1.0 / 5040,     1.0 / 720,     1.0 / 120,    1.0 / 24,
+    1.0 / 6,        1.0 / 2,       1.0,          1.0};
+
+// Scalar twin of the vector exp, used for loop tails so that every element of
+// a vector gets the same approximation.
+double ExpPolynomial(double x) {
+  x = std::fmin(std::fmax(x, kExpMin), kExpMax);
+  double k = (x * kLog2e + kRoundMagic) - kRoundMagic;
+  double r = (x - k * kLn2Hi) - k * kLn2Lo;
+  double p = kExpCoefficients[0];
+  for (std::size_t i = 1; i <= kExpDegree; i++) p = p * r + kExpCoefficients[i];
+  return std::ldexp(p, static_cast<int>(k));
+}
+
+double SigmoidPolynomial(double x) { return 1.0 / (1.0 + ExpPolynomial(-x)); }
+
+/* SSE4.2 */
+
+__attribute__((target("sse4.2"))) __m128d ExpSse42(__m128d x) {
+  const __m128d magic = _mm_set1_pd(kRoundMagic);
+  x = _mm_min_pd(_mm_max_pd(x, _mm_set1_pd(kExpMin)), _mm_set1_pd(kExpMax));
+  __m128d t = _mm_add_pd(_mm_mul_pd(x, _mm_set1_pd(kLog2e)), magic);
+  __m128d k = _mm_sub_pd(t, magic);
+  __m128d r = _mm_sub_pd(_mm_sub_pd(x, _mm_mul_pd(k, _mm_set1_pd(kLn2Hi))),
+                         _mm_mul_pd(k, _mm_set1_pd(kLn2Lo)));
+  __m128d p = _mm_set1_pd(kExpCoefficients[0]);
+  for (std::size_t i = 1; i <= kExpDegree; i++) {
+    p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(kExpCoefficients[i]));
+  }
+  __m128i exponent =
+      _mm_sub_epi64(_mm_castpd_si128(t), _mm_castpd_si128(magic));
+  exponent = _mm_slli_epi64(_mm_add_epi64(exponent, _mm_set1_epi64x(1023)), 52);
+  return _mm_mul_pd(p, _mm_castsi128_pd(exponent));
+}
+
+__attribute__((target("sse4.2"))) double DotSse42(std::size_t n,
+                                                  const double* x,
+                                                  const double* y) {
+  __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    acc0 =
+        _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+    acc1 = _mm_add_pd(
+        acc1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+  }
+  acc0 = _mm_add_pd(acc0, acc1);
+  double sum = _mm_cvtsd_f64(_mm_add_sd(acc0, _mm_unpackhi_pd(acc0, acc0)));
+  for (; i < n; i++) sum += x[i] * y[i];
+  return sum;
+}
+
+__attribute__((target("sse4.2"))) void AxpySse42(std::size_t n, double alpha,
+                                                 const double* x, double* y) {
+  const __m128d a = _mm_set1_pd(alpha);
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i),
+                                    _mm_mul_pd(a, _mm_loadu_pd(x + i))));
+  }
+  for (; i < n; i++) y[i] += alpha * x[i];
+}
+
+__attribute__((target("sse4.2"))) void GemvSse42(std::size_t m, std::size_t n,
+                                                 const double* a,
+                                                 std::size_t lda,
+                                                 const double* x, double* y) {
+  for (std::size_t i = 0; i < m; i++) y[i] = DotSse42(n, a + i * lda, x);
+}
+
+// Four bytes at a time: zero-extend to 32-bit lanes, then convert each half.
+__attribute__((target("sse4.2"))) void ScaleBytesSse42(std::size_t n,
+                                                       double alpha,
+                                                       const std::uint8_t* x,
+                                                       double* y) {
+  const __m128d scale = _mm_set1_pd(alpha);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    std::int32_t bytes;
+    std::memcpy(&bytes, x + i, sizeof(bytes));
+    __m128i v = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes));
+    _mm_storeu_pd(y + i, _mm_mul_pd(_mm_cvtepi32_pd(v), scale));
+    _mm_storeu_pd(y + i + 2,
+                  _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(v, 8)), scale));
+  }
+  for (; i < n; i++) y[i] = alpha * x[i];
+}
+
+__attribute__((target("sse4.2"))) void MulSse42(std::size_t n, const double* x,
+                                                double* y) {
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    _mm_storeu_pd(y + i, _mm_mul_pd(_mm_loadu_pd(y + i), _mm_loadu_pd(x + i)));
+  }
+  for (; i < n; i++) y[i] *= x[i];
+}
+
+__attribute__((target("sse4.2"))) void SigmoidSse42(std::size_t n,
+                                                    const double* x,
+                                                    double* y) {
+  const __m128d one = _mm_set1_pd(1.0);
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128d e = ExpSse42(_mm_sub_pd(_mm_setzero_pd(), _mm_loadu_pd(x + i)));
+    _mm_storeu_pd(y + i, _mm_div_pd(one, _mm_add_pd(one, e)));
+  }
+  for (; i < n; i++) y[i] = SigmoidPolynomial(x[i]);
+}
+
+__attribute__((target("sse4.2"))) void MulSigmoidDerivativeSse42(
+    std::size_t n, const double* y, double* e) {
+  const __m128d one = _mm_set1_pd(1.0);
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128d v = _mm_loadu_pd(y + i);
+    __m128d d = _mm_mul_pd(v, _mm_sub_pd(one, v));
+    _mm_storeu_pd(e + i, _mm_mul_pd(_mm_loadu_pd(e + i), d));
+  }
+  for (; i < n; i++) e[i] *= y[i] * (1.0 - y[i]);
+}
+
+/* AVX2 + FMA */
+
+__attribute__((target("avx2,fma"))) double HorizontalSumAvx2(__m256d v) {
+  __m128d lo = _mm_add_pd(_mm256_castpd256_pd128(v),
+                          _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+__attribute__((target("avx2,fma"))) __m256d ExpAvx2(__m256d x) {
+  const __m256d magic = _mm256_set1_pd(kRoundMagic);
+  x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(kExpMin)),
+                    _mm256_set1_pd(kExpMax));
+  __m256d t = _mm256_fmadd_pd(x, _mm256_set1_pd(kLog2e), magic);
+  __m256d k = _mm256_sub_pd(t, magic);
+  __m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(kLn2Hi), x);
+  r = _mm256_fnmadd_pd(k, _mm256_set1_pd(kLn2Lo), r);
+  __m256d p = _mm256_set1_pd(kExpCoefficients[0]);
+  for (std::size_t i = 1; i <= kExpDegree; i++) {
+    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(kExpCoefficients[i]));
+  }
+  __m256i exponent =
+      _mm256_sub_epi64(_mm256_castpd_si256(t), _mm256_castpd_si256(magic));
+  exponent = _mm256_slli_epi64(
+      _mm256_add_epi64(exponent, _mm256_set1_epi64x(1023)), 52);
+  return _mm256_mul_pd(p, _mm256_castsi256_pd(exponent));
+}
+
+__attribute__((target("avx2,fma"))) double DotAvx2(std::size_t n,
+                                                   const double* x,
+                                                   const double* y) {
+  __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+  __m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i),
+                           acc0);
+    acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4),
+                           _mm256_loadu_pd(y + i + 4), acc1);
+    acc2 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 8),
+                           _mm256_loadu_pd(y + i + 8), acc2);
+    acc3 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 12),
+                           _mm256_loadu_pd(y + i + 12), acc3);
+  }
+  for (; i + 4 <= n; i += 4) {
+    acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i),
+                           acc0);
+  }
+  double sum = HorizontalSumAvx2(
+      _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+  for (; i < n; i++) sum += x[i] * y[i];
+  return sum;
+}
+
+__attribute__((target("avx2,fma"))) void AxpyAvx2(std::size_t n, double alpha,
+                                                  const double* x, double* y) {
+  const __m256d a = _mm256_set1_pd(alpha);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i),
+                                            _mm256_loadu_pd(y + i)));
+  }
+  for (; i < n; i++) y[i] += alpha * x[i];
+}
+
+// Four rows per pass so that every load of x feeds four FMAs.
+__attribute__((target("avx2,fma"))) void GemvAvx2(std::size_t m, std::size_t n,
+                                                  const double* a,
+                                                  std::size_t lda,
+                                                  const double* x, double* y) {
+  std::size_t i = 0;
+  for (; i + 4 <= m; i += 4) {
+    const double* a0 = a + i * lda;
+    const double* a1 = a0 + lda;
+    const double* a2 = a1 + lda;
+    const double* a3 = a2 + lda;
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+    std::size_t j = 0;
+    for (; j + 4 <= n; j += 4) {
+      __m256d v = _mm256_loadu_pd(x + j);
+      acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a0 + j), v, acc0);
+      acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a1 + j), v, acc1);
+      acc2 = _mm256_fmadd_pd(_mm256_loadu_pd(a2 + j), v, acc2);
+      acc3 = _mm256_fmadd_pd(_mm256_loadu_pd(a3 + j), v, acc3);
+    }
+    double s0 = HorizontalSumAvx2(acc0), s1 = HorizontalSumAvx2(acc1);
+    double s2 = HorizontalSumAvx2(acc2), s3 = HorizontalSumAvx2(acc3);
+    for (; j < n; j++) {
+      s0 += a0[j] * x[j];
+      s1 += a1[j] * x[j];
+      s2 += a2[j] * x[j];
+      s3 += a3[j] * x[j];
+    }
+    y[i] = s0;
+    y[i + 1] = s1;
+    y[i + 2] = s2;
+    y[i + 3] = s3;
+  }
+  for (; i < m; i++) y[i] = DotAvx2(n, a + i * lda, x);
+}
+
+__attribute__((target("avx2,fma"))) void ScaleBytesAvx2(std::size_t n,
+                                                        double alpha,
+                                                        const std::uint8_t* x,
+                                                        double* y) {
+  const __m256d scale = _mm256_set1_pd(alpha);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i v = _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(x + i)));
+    _mm256_storeu_pd(
+        y + i,
+        _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(v)), scale));
+    _mm256_storeu_pd(
+        y + i + 4,
+        _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)),
+                      scale));
+  }
+  for (; i < n; i++) y[i] = alpha * x[i];
+}
+
+__attribute__((target("avx2,fma"))) void MulAvx2(std::size_t n, const double* x,
+                                                 double* y) {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(
+        y + i, _mm256_mul_pd(_mm256_loadu_pd(y + i), _mm256_loadu_pd(x + i)));
+  }
+  for (; i < n; i++) y[i] *= x[i];
+}
+
+__attribute__((target("avx2,fma"))) void SigmoidAvx2(std::size_t n,
+                                                     const double* x,
+                                                     double* y) {
+  const __m256d one = _mm256_set1_pd(1.0);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256d e =
+        ExpAvx2(_mm256_sub_pd(_mm256_setzero_pd(), _mm256_loadu_pd(x + i)));
+    _mm256_storeu_pd(y + i, _mm256_div_pd(one, _mm256_add_pd(one, e)));
+  }
+  for (; i < n; i++) y[i] = SigmoidPolynomial(x[i]);
+}
+
+__attribute__((target("avx2,fma"))) void MulSigmoidDerivativeAvx2(
+    std::size_t n, const double* y, double* e) {
+  const __m256d one = _mm256_set1_pd(1.0);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256d v = _mm256_loadu_pd(y + i);
+    __m256d d = _mm256_mul_pd(v, _mm256_sub_pd(one, v));
+    _mm256_storeu_pd(e + i, _mm256_mul_pd(_mm256_loadu_pd(e + i), d));
+  }
+  for (; i < n; i++) e[i] *= y[i] * (1.0 - y[i]);
+}
+
+/* AVX-512: tails are handled with masked loads and stores. */
+
+// GCC 12 flags the _mm512_undefined_* placeholders inside its own intrinsic
+// headers as uninitialized.
+#if !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx512f"))) __mmask8 TailMask(std::size_t count) {
+  return static_cast<__mmask8>((1u << count) - 1);
+}
+
+__attribute__((target("avx512f"))) __m512d ExpAvx512(__m512d x) {
+  const __m512d magic = _mm512_set1_pd(kRoundMagic);
+  x = _mm512_min_pd(_mm512_max_pd(x, _mm512_set1_pd(kExpMin)),
+                    _mm512_set1_pd(kExpMax));
+  __m512d t = _mm512_fmadd_pd(x, _mm512_set1_pd(kLog2e), magic);
+  __m512d k = _mm512_sub_pd(t, magic);
+  __m512d r = _mm512_fnmadd_pd(k, _mm512_set1_pd(kLn2Hi), x);
+  r = _mm512_fnmadd_pd(k, _mm512_set1_pd(kLn2Lo), r);
+  __m512d p = _mm512_set1_pd(kExpCoefficients[0]);
+  for (std::size_t i = 1; i <= kExpDegree; i++) {
+    p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(kExpCoefficients[i]));
+  }
+  __m512i exponent =
+      _mm512_sub_epi64(_mm512_castpd_si512(t), _mm512_castpd_si512(magic));
+  exponent = _mm512_slli_epi64(
+      _mm512_add_epi64(exponent, _mm512_set1_epi64(1023)), 52);
+  return _mm512_mul_pd(p, _mm512_castsi512_pd(exponent));
+}
+
+__attribute__((target("avx512f"))) double DotAvx512(std::size_t n,
+                                                    const double* x,
+                                                    const double* y) {
+  __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i),
+                           acc0);
+    acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8),
+                           _mm512_loadu_pd(y + i + 8), acc1);
+  }
+  for (; i + 8 <= n; i += 8) {
+    acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i),
+                           acc0);
+  }
+  if (i < n) {
+    __mmask8 mask = TailMask(n - i);
+    acc1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x + i),
+                           _mm512_maskz_loadu_pd(mask, y + i), acc1);
+  }
+  return _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1));
+}
+
+__attribute__((target("avx512f"))) void AxpyAvx512(std::size_t n, double alpha,
+                                                   const double* x,
+                                                   double* y) {
+  const __m512d a = _mm512_set1_pd(alpha);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_pd(y + i, _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i),
+                                            _mm512_loadu_pd(y + i)));
+  }
+  if (i < n) {
+    __mmask8 mask = TailMask(n - i);
+    _mm512_mask_storeu_pd(
+        y + i, mask,
+        _mm512_fmadd_pd(a, _mm512_maskz_loadu_pd(mask, x + i),
+                        _mm512_maskz_loadu_pd(mask, y + i)));
+  }
+}
+
+__attribute__((target("avx512f"))) void GemvAvx512(std::size_t m,
+                                                   std::size_t n,
+                                                   const double* a,
+                                                   std::size_t lda,
+                                                   const double* x,
+                                                   double* y) {
+  std::size_t i = 0;
+  const std::size_t tail = n % 8;
+  const __mmask8 mask = TailMask(tail);
+  for (; i + 4 <= m; i += 4) {
+    const double* a0 = a + i * lda;
+    const double* a1 = a0 + lda;
+    const double* a2 = a1 + lda;
+    const double* a3 = a2 + lda;
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    __m512d acc2 = _mm512_setzero_pd(), acc3 = _mm512_setzero_pd();
+    std::size_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+      __m512d v = _mm512_loadu_pd(x + j);
+      acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a0 + j), v, acc0);
+      acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(a1 + j), v, acc1);
+      acc2 = _mm512_fmadd_pd(_mm512_loadu_pd(a2 + j), v, acc2);
+      acc3 = _mm512_fmadd_pd(_mm512_loadu_pd(a3 + j), v, acc3);
+    }
+    if (tail != 0) {
+      __m512d v = _mm512_maskz_loadu_pd(mask, x + j);
+      acc0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a0 + j), v, acc0);
+      acc1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a1 + j), v, acc1);
+      acc2 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a2 + j), v, acc2);
+      acc3 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a3 + j), v, acc3);
+    }
+    y[i] = _mm512_reduce_add_pd(acc0);
+    y[i + 1] = _mm512_reduce_add_pd(acc1);
+    y[i + 2] = _mm512_reduce_add_pd(acc2);
+    y[i + 3] = _mm512_reduce_add_pd(acc3);
+  }
+  for (; i < m; i++) y[i] = DotAvx512(n, a + i * lda, x);
+}
+
+// Byte loads cannot be masked without AVX-512BW, so the tail is scalar.
+__attribute__((target("avx512f"))) void ScaleBytesAvx512(std::size_t n,
+                                                         double alpha,
+                                                         const std::uint8_t* x,
+                                                         double* y) {
+  const __m512d scale = _mm512_set1_pd(alpha);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i v = _mm512_cvtepu8_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+    _mm512_storeu_pd(
+        y + i,
+        _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(v)), scale));
+    _mm512_storeu_pd(
+        y + i + 8,
+        _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(v, 1)),
+                      scale));
+  }
+  for (; i < n; i++) y[i] = alpha * x[i];
+}
+
+__attribute__((target("avx512f"))) void MulAvx512(std::size_t n,
+                                                  const double* x, double* y) {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_pd(
+        y + i, _mm512_mul_pd(_mm512_loadu_pd(y + i), _mm512_loadu_pd(x + i)));
+  }
+  if (i < n) {
+    __mmask8 mask = TailMask(n - i);
+    _mm512_mask_storeu_pd(y + i, mask,
+                          _mm512_mul_pd(_mm512_maskz_loadu_pd(mask, y + i),
+                                        _mm512_maskz_loadu_pd(mask, x + i)));
+  }
+}
+
+__attribute__((target("avx512f"))) void SigmoidAvx512(std::size_t n,
+                                                      const double* x,
+                                                      double* y) {
+  const __m512d one = _mm512_set1_pd(1.0);
+  for (std::size_t i = 0; i < n; i += 8) {
+    __mmask8 mask = TailMask(n - i < 8 ? n - i : 8);
+    __m512d e = ExpAvx512(
+        _mm512_sub_pd(_mm512_setzero_pd(), _mm512_maskz_loadu_pd(mask, x + i)));
+    _mm512_mask_storeu_pd(y + i, mask,
+                          _mm512_div_pd(one, _mm512_add_pd(one, e)));
+  }
+}
+
+__attribute__((target("avx512f"))) void MulSigmoidDerivativeAvx512(
+    std::size_t n, const double* y, double* e) {
+  const __m512d one = _mm512_set1_pd(1.0);
+  for (std::size_t i = 0; i < n; i += 8) {
+    __mmask8 mask = TailMask(n - i < 8 ? n - i : 8);
+    __m512d v = _mm512_maskz_loadu_pd(mask, y + i);
+    __m512d d = _mm512_mul_pd(v, _mm512_sub_pd(one, v));
+    _mm512_mask_storeu_pd(
+        e + i, mask, _mm512_mul_pd(_mm512_maskz_loadu_pd(mask, e + i), d));
+  }
+}
+
+#if !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+constexpr KernelTable kSse42Table = {
+    InstructionSet::kSse42, DotSse42,        AxpySse42,
+    GemvSse42,              ScaleBytesSse42, MulSse42,
+    SigmoidSse42,           MulSigmoidDerivativeSse42};
+
+constexpr KernelTable kAvx2Table = {
+    InstructionSet::kAvx2, DotAvx2,        AxpyAvx2,
+    GemvAvx2,              ScaleBytesAvx2, MulAvx2,
+    SigmoidAvx2,           MulSigmoidDerivativeAvx2};
+
+constexpr KernelTable kAvx512Table = {
+    InstructionSet::kAvx512, DotAvx512,        AxpyAvx512,
+    GemvAvx512,              ScaleBytesAvx512, MulAvx512,
+    SigmoidAvx512,           MulSigmoidDerivativeAvx512};
+
+/* Single precision, AVX2 + FMA. The sigmoid widens to double and reuses the
+   double exp, which keeps it well inside float accuracy. */
+
+__attribute__((target("avx2,fma"))) float HorizontalSumAvx2(__m256 v) {
+  __m128 lo =
+      _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+  return _mm_cvtss_f32(_mm_add_ss(lo, _mm_movehdup_ps(lo)));
+}
+
+__attribute__((target("avx2,fma"))) float DotAvx2Float(std::size_t n,
+                                                       const float* x,
+                                                       const float* y) {
+  __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+  __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i),
+                           acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8),
+                           _mm256_loadu_ps(y + i + 8), acc1);
+    acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 16),
+                           _mm256_loadu_ps(y + i + 16), acc2);
+    acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 24),
+                           _mm256_loadu_ps(y + i + 24), acc3);
+  }
+  for (; i + 8 <= n; i += 8) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i),
+                           acc0);
+  }
+  float sum = HorizontalSumAvx2(
+      _mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+  for (; i < n; i++) sum += x[i] * y[i];
+  return sum;
+}
+
+__attribute__((target("avx2,fma"))) void AxpyAvx2Float(std::size_t n,
+                                                       float alpha,
+                                                       const float* x,
+                                                       float* y) {
+  const __m256 a = _mm256_set1_ps(alpha);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(y + i, _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i),
+                                            _mm256_loadu_ps(y + i)));
+  }
+  for (; i < n; i++) y[i] += alpha * x[i];
+}
+
+__attribute__((target("avx2,fma"))) void GemvAvx2Float(std::size_t m,
+                                                       std::size_t n,
+                                                       const float* a,
+                                                       std::size_t lda,
+                                                       const float* x,
+                                                       float* y) {
+  std::size_t i = 0;
+  for (; i + 4 <= m; i += 4) {
+    const float* a0 = a + i * lda;
+    const float* a1 = a0 + lda;
+    const float* a2 = a1 + lda;
+    const float* a3 = a2 + lda;
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+    std::size_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+      __m256 v = _mm256_loadu_ps(x + j);
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a0 + j), v, acc0);
+      acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a1 + j), v, acc1);
+      acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a2 + j), v, acc2);
+      acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a3 + j), v, acc3);
+    }
+    float s0 = HorizontalSumAvx2(acc0), s1 = HorizontalSumAvx2(acc1);
+    float s2 = HorizontalSumAvx2(acc2), s3 = HorizontalSumAvx2(acc3);
+    for (; j < n; j++) {
+      s0 += a0[j] * x[j];
+      s1 += a1[j] * x[j];
+      s2 += a2[j] * x[j];
+      s3 += a3[j] * x[j];
+    }
+    y[i] = s0;
+    y[i + 1] = s1;
+    y[i + 2] = s2;
+    y[i + 3] = s3;
+  }
+  for (; i < m; i++) y[i] = DotAvx2Float(n, a + i * lda, x);
+}
+
+__attribute__((target("avx2,fma"))) void ScaleBytesAvx2Float(
+    std::size_t n, float alpha, const std::uint8_t* x, float* y) {
+  const __m256 scale = _mm256_set1_ps(alpha);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i v = _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(x + i)));
+    _mm256_storeu_ps(y + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+  }
+  for (; i < n; i++) y[i] = alpha * x[i];
+}
+
+__attribute__((target("avx2,fma"))) void MulAvx2Float(std::size_t n,
+                                                      const float* x,
+                                                      float* y) {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(
+        y + i, _mm256_mul_ps(_mm256_loadu_ps(y + i), _mm256_loadu_ps(x + i)));
+  }
+  for (; i < n; i++) y[i] *= x[i];
+}
+
+__attribute__((target("avx2,fma"))) void SigmoidAvx2Float(std::size_t n,
+                                                          const float* x,
+                                                          float* y) {
+  const __m256d one = _mm256_set1_pd(1.0);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256d v = _mm256_cvtps_pd(_mm_loadu_ps(x + i));
+    __m256d e = ExpAvx2(_mm256_sub_pd(_mm256_setzero_pd(), v));
+    _mm_storeu_ps(y + i,
+                  _mm256_cvtpd_ps(_mm256_div_pd(one, _mm256_add_pd(one, e))));
+  }
+  for (; i < n; i++) y[i] = static_cast<float>(SigmoidPolynomial(x[i]));
+}
+
+__attribute__((target("avx2,fma"))) void MulSigmoidDerivativeAvx2Float(
+    std::size_t n, const float* y, float* e) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 v = _mm256_loadu_ps(y + i);
+    __m256 d = _mm256_mul_ps(v, _mm256_sub_ps(one, v));
+    _mm256_storeu_ps(e + i, _mm256_mul_ps(_mm256_loadu_ps(e + i), d));
+  }
+  for (; i < n; i++) e[i] *= y[i] * (1.0f - y[i]);
+}
+
+/* Single precision, AVX-512. */
+
+#if !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx512f"))) __mmask16 TailMask16(std::size_t count) {
+  return static_cast<__mmask16>((1u << count) - 1);
+}
+
+__attribute__((target("avx512f"))) float DotAvx512Float(std::size_t n,
+                                                        const float* x,
+                                                        const float* y) {
+  __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i),
+                           acc0);
+    acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16),
+                           _mm512_loadu_ps(y + i + 16), acc1);
+  }
+  for (; i + 16 <= n; i += 16) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i),
+                           acc0);
+  }
+  if (i < n) {
+    __mmask16 mask = TailMask16(n - i);
+    acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x + i),
+                           _mm512_maskz_loadu_ps(mask, y + i), acc1);
+  }
+  return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+__attribute__((target("avx512f"))) void AxpyAvx512Float(std::size_t n,
+                                                        float alpha,
+                                                        const float* x,
+                                                        float* y) {
+  const __m512 a = _mm512_set1_ps(alpha);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm512_storeu_ps(y + i, _mm512_fmadd_ps(a, _mm512_loadu_ps(x + i),
+                                            _mm512_loadu_ps(y + i)));
+  }
+  if (i < n) {
+    __mmask16 mask = TailMask16(n - i);
+    _mm512_mask_storeu_ps(
+        y + i, mask,
+        _mm512_fmadd_ps(a, _mm512_maskz_loadu_ps(mask, x + i),
+                        _mm512_maskz_loadu_ps(mask, y + i)));
+  }
+}
+
+__attribute__((target("avx512f"))) void GemvAvx512Float(std::size_t m,
+                                                        std::size_t n,
+                                                        const float* a,
+                                                        std::size_t lda,
+                                                        const float* x,
+                                                        float* y) {
+  const std::size_t tail = n % 16;
+  const __mmask16 mask = TailMask16(tail);
+  std::size_t i = 0;
+  for (; i + 4 <= m; i += 4) {
+    const float* a0 = a + i * lda;
+    const float* a1 = a0 + lda;
+    const float* a2 = a1 + lda;
+    const float* a3 = a2 + lda;
+    __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+    __m512 acc2 = _mm512_setzero_ps(), acc3 = _mm512_setzero_ps();
+    std::size_t j = 0;
+    for (; j + 16 <= n; j += 16) {
+      __m512 v = _mm512_loadu_ps(x + j);
+      acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a0 + j), v, acc0);
+      acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a1 + j), v, acc1);
+      acc2 = _mm512_fmadd_ps(_mm512_loadu_ps(a2 + j), v, acc2);
+      acc3 = _mm512_fmadd_ps(_mm512_loadu_ps(a3 + j), v, acc3);
+    }
+    if (tail != 0) {
+      __m512 v = _mm512_maskz_loadu_ps(mask, x + j);
+      acc0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a0 + j), v, acc0);
+      acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a1 + j), v, acc1);
+      acc2 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a2 + j), v, acc2);
+      acc3 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a3 + j), v, acc3);
+    }
+    y[i] = _mm512_reduce_add_ps(acc0);
+    y[i + 1] = _mm512_reduce_add_ps(acc1);
+    y[i + 2] = _mm512_reduce_add_ps(acc2);
+    y[i + 3] = _mm512_reduce_add_ps(acc3);
+  }
+  for (; i < m; i++) y[i] = DotAvx512Float(n, a + i * lda, x);
+}
+
+__attribute__((target("avx512f"))) void ScaleBytesAvx512Float(
+    std::size_t n, float alpha, const std::uint8_t* x, float* y) {
+  const __m512 scale = _mm512_set1_ps(alpha);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i v = _mm512_cvtepu8_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+    _mm512_storeu_ps(y + i, _mm512_mul_ps(_mm512_cvtepi32_ps(v), scale));
+  }
+  for (; i < n; i++) y[i] = alpha * x[i];
+}
+
+__attribute__((target("avx512f"))) void MulAvx512Float(std::size_t n,
+                                                       const float* x,
+                                                       float* y) {
+  for (std::size_t i = 0; i < n; i += 16) {
+    __mmask16 mask = TailMask16(n - i < 16 ? n - i : 16);
+    _mm512_mask_storeu_ps(y + i, mask,
+                          _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, y + i),
+                                        _mm512_maskz_loadu_ps(mask, x + i)));
+  }
+}
+
+__attribute__((target("avx512f"))) void SigmoidAvx512Float(std::size_t n,
+                                                           const float* x,
+                                                           float* y) {
+  const __m512d one = _mm512_set1_pd(1.0);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512d v = _mm512_cvtps_pd(_mm256_loadu_ps(x + i));
+    __m512d e = ExpAvx512(_mm512_sub_pd(_mm512_setzero_pd(), v));
+    _mm256_storeu_ps(
+        y + i, _mm512_cvtpd_ps(_mm512_div_pd(one, _mm512_add_pd(one, e))));
+  }
+  for (; i < n; i++) y[i] = static_cast<float>(SigmoidPolynomial(x[i]));
+}
+
+__attribute__((target("avx512f"))) void MulSigmoidDerivativeAvx512Float(
+    std::size_t n, const float* y, float* e) {
+  const __m512 one = _mm512_set1_ps(1.0f);
+  for (std::size_t i = 0; i < n; i += 16) {
+    __mmask16 mask = TailMask16(n - i < 16 ? n - i : 16);
+    __m512 v = _mm512_maskz_loadu_ps(mask, y + i);
+    __m512 d = _mm512_mul_ps(v, _mm512_sub_ps(one, v));
+    _mm512_mask_storeu_ps(
+        e + i, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, e + i), d));
+  }
+}
+
+#if !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+constexpr FloatKernelTable kAvx2FloatTable = {
+    DotAvx2Float,        AxpyAvx2Float, GemvAvx2Float,
+    ScaleBytesAvx2Float, MulAvx2Float,  SigmoidAvx2Float,
+    MulSigmoidDerivativeAvx2Float};
+
+constexpr FloatKernelTable kAvx512FloatTable = {
+    DotAvx512Float,        AxpyAvx512Float, GemvAvx512Float,
+    ScaleBytesAvx512Float, MulAvx512Float,  SigmoidAvx512Float,
+    MulSigmoidDerivativeAvx512Float};
+
+/* 8-bit integer. maddubs multiplies unsigned by signed bytes and adds
+   adjacent pairs into saturating 16-bit lanes; with x below 128 a pair stays
+   within 2 * 127 * 128, so it never saturates. VNNI's dpbusd does the same
+   straight into 32-bit lanes. */
+
+__attribute__((target("avx2"))) std::int32_t HorizontalSumAvx2(__m256i v) {
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v),
+                              _mm256_extracti128_si256(v, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+  return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("avx2"))) void GemvS8Avx2(std::size_t m, std::size_t n,
+                                                const std::int8_t* a,
+                                                std::size_t lda,
+                                                const std::uint8_t* x,
+                                                std::int32_t* y) {
+  const __m256i ones = _mm256_set1_epi16(1);
+  for (std::size_t i = 0; i < m; i++) {
+    const std::int8_t* row = a + i * lda;
+    __m256i acc = _mm256_setzero_si256();
+    std::size_t j = 0;
+    for (; j + 32 <= n; j += 32) {
+      __m256i pairs = _mm256_maddubs_epi16(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + j)),
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + j)));
+      acc = _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, ones));
+    }
+    std::int32_t sum = HorizontalSumAvx2(acc);
+    for (; j < n; j++) sum += row[j] * x[j];
+    y[i] = sum;
+  }
+}
+
+#if !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx512f,avx512bw,avx512vnni"))) void GemvS8Avx512Vnni(
+    std::size_t m, std::size_t n, const std::int8_t* a, std::size_t lda,
+    const std::uint8_t* x, std::int32_t* y) {
+  const std::size_t tail = n % 64;
+  const __mmask64 mask = tail == 0 ? 0 : (~0ull >> (64 - tail));
+  std::size_t i = 0;
+  for (; i + 4 <= m; i += 4) {
+    const std::int8_t* a0 = a + i * lda;
+    const std::int8_t* a1 = a0 + lda;
+    const std::int8_t* a2 = a1 + lda;
+    const std::int8_t* a3 = a2 + lda;
+    __m512i acc0 = _mm512_setzero_si512(), acc1 = _mm512_setzero_si512();
+    __m512i acc2 = _mm512_setzero_si512(), acc3 = _mm512_setzero_si512();
+    for (std::size_t j = 0; j < n; j += 64) {
+      const __mmask64 k = n - j < 64 ? mask : ~0ull;
+      __m512i v = _mm512_maskz_loadu_epi8(k, x + j);
+      acc0 = _mm512_dpbusd_epi32(acc0, v, _mm512_maskz_loadu_epi8(k, a0 + j));
+      acc1 = _mm512_dpbusd_epi32(acc1, v, _mm512_maskz_loadu_epi8(k, a1 + j));
+      acc2 = _mm512_dpbusd_epi32(acc2, v, _mm512_maskz_loadu_epi8(k, a2 + j));
+      acc3 = _mm512_dpbusd_epi32(acc3, v, _mm512_maskz_loadu_epi8(k, a3 + j));
+    }
+    y[i] = _mm512_reduce_add_epi32(acc0);
+    y[i + 1] = _mm512_reduce_add_epi32(acc1);
+    y[i + 2] = _mm512_reduce_add_epi32(acc2);
+    y[i + 3] = _mm512_reduce_add_epi32(acc3);
+  }
+  for (; i < m; i++) {
+    const std::int8_t* row = a + i * lda;
+    __m512i acc = _mm512_setzero_si512();
+    for (std::size_t j = 0; j < n; j += 64) {
+      const __mmask64 k = n - j < 64 ? mask : ~0ull;
+      acc = _mm512_dpbusd_epi32(acc, _mm512_maskz_loadu_epi8(k, x + j),
+                                _mm512_maskz_loadu_epi8(k, row + j));
+    }
+    y[i] = _mm512_reduce_add_epi32(acc);
+  }
+}
+
+#if !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+bool HasVnni() {
+  static const bool vnni = __builtin_cpu_supports("avx512vnni") &&
+                           __builtin_cpu_supports("avx512bw");
+  return vnni;
+}
+
+#endif  // S21_KERNELS_X86
+
+const KernelTable* TableFor(InstructionSet set) {
+  switch (set) {
+#ifdef S21_KERNELS_X86
+    case InstructionSet::kAvx512:
+      return &kAvx512Table;
+    case InstructionSet::kAvx2:
+      return &kAvx2Table;
+    case InstructionSet::kSse42:
+      return &kSse42Table;
+#endif
+    default:
+      return &kScalarTable;
+  }
+}
+
+std::atomic<const KernelTable*>& ActiveTable() {
+  static std::atomic<const KernelTable*> table(
+      TableFor(DetectInstructionSet()));
+  return table;
+}
+
+const KernelTable& Table() {
+  return *ActiveTable().load(std::memory_order_relaxed);
+}
+
+// Follows the double table, so SetInstructionSet switches both.
+const FloatKernelTable& FloatTable() {
+  switch (Table().set) {
+#ifdef S21_KERNELS_X86
+    case InstructionSet::kAvx512:
+      return kAvx512FloatTable;
+    case InstructionSet::kAvx2:
+      return kAvx2FloatTable;
+#endif
+    default:
+      return kScalarFloatTable;
+  }
+}
+
+// Also follows the double table. AVX-512 without VNNI falls back to AVX2.
+GemvS8Kernel GemvS8Function() {
+  switch (Table().set) {
+#ifdef S21_KERNELS_X86
+    case InstructionSet::kAvx512:
+      return HasVnni() ? GemvS8Avx512Vnni : GemvS8Avx2;
+    case InstructionSet::kAvx2:
+      return GemvS8Avx2;
+#endif
+    default:
+      return GemvS8Scalar;
+  }
+}
+
+}  // namespace
+
+InstructionSet DetectInstructionSet() {
+  InstructionSet set = InstructionSet::kScalar;
+#ifdef S21_KERNELS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    set = InstructionSet::kAvx512;
+  } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    set = InstructionSet::kAvx2;
+  } else if (__builtin_cpu_supports("sse4.2")) {
+    set = InstructionSet::kSse42;
+  }
+#endif
+  return set;
+}
+
+InstructionSet GetInstructionSet() { return Table().set; }
+
+InstructionSet SetInstructionSet(InstructionSet set) {
+  if (static_cast<int>(set) > static_cast<int>(DetectInstructionSet())) {
+    set = DetectInstructionSet();
+  }
+  ActiveTable().store(TableFor(set), std::memory_order_relaxed);
+  return GetInstructionSet();
+}
+
+const char* InstructionSetName(InstructionSet set) {
+  switch (set) {
+    case InstructionSet::kAvx512:
+      return "AVX-512";
+    case InstructionSet::kAvx2:
+      return "AVX2";
+    case InstructionSet::kSse42:
+      return "SSE4.2";
+    default:
+      return "scalar";
+  }
+}
+
+double Dot(std::size_t n, const double* x, const double* y) {
+  return Table().dot(n, x, y);
+}
+
+void Axpy(std::size_t n, double alpha, const double* x, double* y) {
+  Table().axpy(n, alpha, x, y);
+}
+
+void Gemv(std::size_t m, std::size_t n, const double* a, std::size_t lda,
+          const double* x, double* y) {
+  Table().gemv(m, n, a, lda, x, y);
+}
+
+void GemvTransposed(std::size_t m, std::size_t n, const double* a,
+                    std::size_t lda, const double* x, double* y) {
+  const KernelTable& table = Table();
+  for (std::size_t j = 0; j < n; j++) y[j] = 0;
+  for (std::size_t i = 0; i < m; i++) table.axpy(n, x[i], a + i * lda, y);
+}
+
+void Ger(std::size_t m, std::size_t n, double alpha, const double* x,
+         const double* y, double* a, std::size_t lda) {
+  const KernelTable& table = Table();
+  for (std::size_t i = 0; i < m; i++) {
+    table.axpy(n, alpha * x[i], y, a + i * lda);
+  }
+}
+
+void ScaleBytes(std::size_t n, double alpha, const std::uint8_t* x,
+                double* y) {
+  Table().scale_bytes(n, alpha, x, y);
+}
+
+void Mul(std::size_t n, const double* x, double* y) { Table().mul(n, x, y); }
+
+void Sigmoid(std::size_t n, const double* x, double* y) {
+  Table().sigmoid(n, x, y);
+}
+
+void MulSigmoidDerivative(std::size_t n, const double* y, double* e) {
+  Table().mul_sigmoid_derivative(n, y, e);
+}
+
+float Dot(std::size_t n, const float* x, const float* y) {
+  return FloatTable().dot(n, x, y);
+}
+
+void Axpy(std::size_t n, float alpha, const float* x, float* y) {
+  FloatTable().axpy(n, alpha, x, y);
+}
+
+void Gemv(std::size_t m, std::size_t n, const float* a, std::size_t lda,
+          const float* x, float* y) {
+  FloatTable().gemv(m, n, a, lda, x, y);
+}
+
+void GemvTransposed(std::size_t m, std::size_t n, const float* a,
+                    std::size_t lda, const float* x, float* y) {
+  const FloatKernelTable& table = FloatTable();
+  for (std::size_t j = 0; j < n; j++) y[j] = 0;
+  for (std::size_t i = 0; i < m; i++) table.axpy(n, x[i], a + i * lda, y);
+}
+
+void Ger(std::size_t m, std::size_t n, float alpha, const float* x,
+         const float* y, float* a, std::size_t lda) {
+  const FloatKernelTable& table = FloatTable();
+  for (std::size_t i = 0; i < m; i++) {
+    table.axpy(n, alpha * x[i], y, a + i * lda);
+  }
+}
+
+void ScaleBytes(std::size_t n, float alpha, const std::uint8_t* x, float* y) {
+  FloatTable().scale_bytes(n, alpha, x, y);
+}
+
+void Mul(std::size_t n, const float* x, float* y) {
+  FloatTable().mul(n, x, y);
+}
+
+void Sigmoid(std::size_t n, const float* x, float* y) {
+  FloatTable().sigmoid(n, x, y);
+}
+
+void MulSigmoidDerivative(std::size_t n, const float* y, float* e) {
+  FloatTable().mul_sigmoid_derivative(n, y, e);
+}
+
+void GemvS8(std::size_t m, std::size_t n, const std::int8_t* a,
+            std::size_t lda, const std::uint8_t* x, std::int32_t* y) {
+  GemvS8Function()(m, n, a, lda, x, y);
+}
+
+}  // namespace s21::kernels
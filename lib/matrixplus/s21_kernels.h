@@ -0,0 +1,86 @@
+#ifndef SRC_LIB_MATRIXPLUS_S21_KERNELS_H_
+#define SRC_LIB_MATRIXPLUS_S21_KERNELS_H_
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace s21::kernels {
+
+// Level 1 and level 2 BLAS-style kernels over raw row-major storage.
+//
+// Every kernel has a scalar implementation and, on x86, SSE4.2, AVX2+FMA and
+// AVX-512 ones compiled with per-function target attributes. The widest set
+// supported by the running CPU is picked on first use, so a single binary runs
+// everywhere.
+
+enum class InstructionSet { kScalar = 0, kSse42, kAvx2, kAvx512 };
+
+// Widest instruction set supported by this CPU and OS.
+InstructionSet DetectInstructionSet();
+// Instruction set the kernels currently dispatch to.
+InstructionSet GetInstructionSet();
+// Forces dispatch to |set|, clamped to what the CPU supports. Returns the set
+// actually selected. Meant for tests and benchmarks.
+InstructionSet SetInstructionSet(InstructionSet set);
+const char* InstructionSetName(InstructionSet set);
+
+// Returns sum(x[i] * y[i]).
+double Dot(std::size_t n, const double* x, const double* y);
+
+// y += alpha * x
+void Axpy(std::size_t n, double alpha, const double* x, double* y);
+
+// y = A * x, A is m x n.
+void Gemv(std::size_t m, std::size_t n, const double* a, std::size_t lda,
+          const double* x, double* y);
+
+// y = A^T * x, A is m x n. Walks A row by row, so no transpose is formed.
+void GemvTransposed(std::size_t m, std::size_t n, const double* a,
+                    std::size_t lda, const double* x, double* y);
+
+// A += alpha * x * y^T, A is m x n.
+void Ger(std::size_t m, std::size_t n, double alpha, const double* x,
+         const double* y, double* a, std::size_t lda);
+
+// y[i] = alpha * x[i], widening 8-bit values. Used to feed raw pixels into
+// an input layer without a separate normalisation pass.
+void ScaleBytes(std::size_t n, double alpha, const std::uint8_t* x, double* y);
+
+// y[i] *= x[i]
+void Mul(std::size_t n, const double* x, double* y);
+
+// y[i] = 1 / (1 + exp(-x[i])); x and y may alias. The vector versions use a
+// degree 11 polynomial for exp with relative error below 1e-14.
+void Sigmoid(std::size_t n, const double* x, double* y);
+
+// e[i] *= y[i] * (1 - y[i]), the sigmoid derivative expressed through the
+// sigmoid output y.
+void MulSigmoidDerivative(std::size_t n, const double* y, double* e);
+
+// Single-precision versions of the kernels above, for the float32 network
+// path. They dispatch on the same instruction set.
+float Dot(std::size_t n, const float* x, const float* y);
+void Axpy(std::size_t n, float alpha, const float* x, float* y);
+void Gemv(std::size_t m, std::size_t n, const float* a, std::size_t lda,
+          const float* x, float* y);
+void GemvTransposed(std::size_t m, std::size_t n, const float* a,
+                    std::size_t lda, const float* x, float* y);
+void Ger(std::size_t m, std::size_t n, float alpha, const float* x,
+         const float* y, float* a, std::size_t lda);
+void ScaleBytes(std::size_t n, float alpha, const std::uint8_t* x, float* y);
+void Mul(std::size_t n, const float* x, float* y);
+void Sigmoid(std::size_t n, const float* x, float* y);
+void MulSigmoidDerivative(std::size_t n, const float* y, float* e);
+
+// y = A * x over 8-bit values with 32-bit sums, for int8 inference: A is an
+// m x n matrix of signed weights, x holds unsigned activations that must be
+// below 128. Uses VNNI where the CPU has it and AVX2 maddubs otherwise.
+void GemvS8(std::size_t m, std::size_t n, const std::int8_t* a,
+            std::size_t lda, const std::uint8_t* x, std::int32_t* y);
+
+}  // namespace s21::kernels
+
+#endif  // SRC_LIB_MATRIXPLUS_S21_KERNELS_H_
@@ -2,169 +2,224 @@
 
 namespace s21 {
 
-Matrix::Matrix(std::size_t rows, std::size_t cols) : rows_(rows), cols_(cols) {
+template <typename T>
+BasicMatrix<T>::BasicMatrix(std::size_t rows, std::size_t cols)
+    : rows_(rows), cols_(cols) {
   if (rows == 0 || cols == 0) {
     throw std::invalid_argument("Matrix: rows and columns must be more than 0");
   }
 
-  matrix_ = new double*[rows_];
-
-  for (std::size_t i = 0; i < rows_; i++) {
-    matrix_[i] = new double[cols_]();
-  }
+  matrix_ = Allocate(rows_ * cols_);
+  std::memset(matrix_, 0, GetSize() * sizeof(T));
 }
 
-Matrix::Matrix(const std::vector<double>& row) : Matrix(row.size(), 1) {
-  for (size_t i = 0; i < row.size(); i++) {
-    operator()(i, 0) = row[i];
-  }
+template <typename T>
+BasicMatrix<T>::BasicMatrix(const std::vector<T>& row)
+    : BasicMatrix(row.size(), 1) {
+  std::memcpy(matrix_, row.data(), row.size() * sizeof(T));
 }
 
-Matrix::Matrix(const Matrix& other) {
+template <typename T>
+BasicMatrix<T>::BasicMatrix(const BasicMatrix& other) {
   if (other.rows_ > 0 && other.cols_ > 0) {
-    Matrix m(other.rows_, other.cols_);
-    for (std::size_t i = 0; i < m.rows_; i++) {
-      std::memcpy(m.matrix_[i], other.matrix_[i], other.cols_ * sizeof(double));
-    }
-    Swap(&m);
+    matrix_ = Allocate(other.GetSize());
+    rows_ = other.rows_;
+    cols_ = other.cols_;
+    std::memcpy(matrix_, other.matrix_, GetSize() * sizeof(T));
   }
 }
 
-Matrix::Matrix(Matrix&& other) { Swap(&other); }
+template <typename T>
+BasicMatrix<T>::BasicMatrix(BasicMatrix&& other) { Swap(&other); }
 
-Matrix::~Matrix() {
-  if (matrix_ != nullptr) {
-    for (std::size_t i = 0; i < rows_; i++) {
-      delete[] matrix_[i];
-    }
-    delete[] matrix_;
-    matrix_ = nullptr;
-  }
+template <typename T>
+BasicMatrix<T>::~BasicMatrix() {
+  Deallocate(matrix_);
+  matrix_ = nullptr;
   rows_ = 0;
   cols_ = 0;
 }
 
-void Matrix::Swap(Matrix* other) {
+template <typename T>
+T* BasicMatrix<T>::Allocate(std::size_t size) {
+  return static_cast<T*>(
+      ::operator new[](size * sizeof(T), std::align_val_t(kAlignment)));
+}
+
+template <typename T>
+void BasicMatrix<T>::Deallocate(T* data) {
+  if (data != nullptr) {
+    ::operator delete[](data, std::align_val_t(kAlignment));
+  }
+}
+
+template <typename T>
+void BasicMatrix<T>::Swap(BasicMatrix* other) {
   std::swap(rows_, other->rows_);
   std::swap(cols_, other->cols_);
   std::swap(matrix_, other->matrix_);
 }
 
-std::size_t Matrix::GetRows() const { return rows_; }
+template <typename T>
+std::size_t BasicMatrix<T>::GetRows() const { return rows_; }
 
-void Matrix::SetRows(std::size_t rows) {
+template <typename T>
+void BasicMatrix<T>::SetRows(std::size_t rows) {
   if (rows_ != rows) {
-    Matrix m(rows, cols_);
-    for (std::size_t i = 0; i < std::min(rows_, rows); i++) {
-      std::memcpy(m.matrix_[i], matrix_[i], cols_ * sizeof(double));
-    }
+    BasicMatrix m(rows, cols_);
+    std::memcpy(m.matrix_, matrix_,
+                std::min(rows_, rows) * cols_ * sizeof(T));
     Swap(&m);
   }
 }
 
-std::size_t Matrix::GetColumns() const { return cols_; }
+template <typename T>
+std::size_t BasicMatrix<T>::GetColumns() const { return cols_; }
 
-void Matrix::SetColumns(std::size_t cols) {
+template <typename T>
+void BasicMatrix<T>::SetColumns(std::size_t cols) {
   if (cols_ != cols) {
-    Matrix m(rows_, cols);
+    BasicMatrix m(rows_, cols);
     auto const length = std::min(cols_, cols);
     for (std::size_t i = 0; i < rows_; i++) {
-      std::memcpy(m.matrix_[i], matrix_[i], length * sizeof(double));
+      std::memcpy(m.matrix_ + i * cols, matrix_ + i * cols_,
+                  length * sizeof(T));
     }
     Swap(&m);
   }
 }
 
-bool Matrix::EqMatrix(const Matrix& other) const {
+template <typename T>
+bool BasicMatrix<T>::EqMatrix(const BasicMatrix& other) const {
   bool status = rows_ == other.rows_ && cols_ == other.cols_;
   if (rows_ == 0 || cols_ == 0) {
     throw std::logic_error("EqMatrix: invalid matrix");
   }
-  for (std::size_t i = 0; i < rows_ && status; i++) {
-    for (std::size_t j = 0; j < cols_ && status; j++) {
-      if (std::fabs(matrix_[i][j] - other.matrix_[i][j]) >= kEps) {
-        status = false;
-      }
+  for (std::size_t i = 0; i < GetSize() && status; i++) {
+    if (std::fabs(matrix_[i] - other.matrix_[i]) >= kEps) {
+      status = false;
     }
   }
   return status;
 }
 
-void Matrix::SumMatrix(const Matrix& other) {
+template <typename T>
+void BasicMatrix<T>::SumMatrix(const BasicMatrix& other) {
   if (rows_ != other.rows_ || cols_ != other.cols_ || rows_ == 0 ||
       cols_ == 0) {
     throw std::logic_error(
         "SumMatrix: invalid matrix or different dimensions of the matrix");
   }
-  for (std::size_t i = 0; i < rows_; i++) {
-    for (std::size_t j = 0; j < cols_; j++) {
-      matrix_[i][j] += other.matrix_[i][j];
-    }
-  }
+  kernels::Axpy(GetSize(), 1, other.matrix_, matrix_);
 }
 
-void Matrix::SubMatrix(const Matrix& other) {
+template <typename T>
+void BasicMatrix<T>::SubMatrix(const BasicMatrix& other) {
   if (rows_ != other.rows_ || cols_ != other.cols_ || rows_ == 0 ||
       cols_ == 0) {
     throw std::logic_error(
         "SubMatrix: invalid matrix or different dimensions of the matrix");
   }
-  for (std::size_t i = 0; i < rows_; i++) {
-    for (std::size_t j = 0; j < cols_; j++) {
-      matrix_[i][j] -= other.matrix_[i][j];
-    }
-  }
+  kernels::Axpy(GetSize(), -1, other.matrix_, matrix_);
 }
 
-void Matrix::MulNumber(double number) {
+template <typename T>
+void BasicMatrix<T>::MulNumber(T number) {
   if (rows_ == 0 || cols_ == 0) {
     throw std::logic_error("MulNumber: invalid matrix");
   }
-  for (std::size_t i = 0; i < rows_; i++) {
-    for (std::size_t j = 0; j < cols_; j++) {
-      matrix_[i][j] *= number;
-    }
+  for (std::size_t i = 0; i < GetSize(); i++) {
+    matrix_[i] *= number;
   }
 }
 
-void Matrix::MulMatrix(const Matrix& other) {
-  if (cols_ != other.rows_ || rows_ == 0 || cols_ == 0 || other.rows_ == 0 ||
-      other.cols_ == 0) {
+template <typename T>
+void BasicMatrix<T>::MulMatrix(const BasicMatrix& other) {
+  BasicMatrix m = Multiply(*this, other);
+  Swap(&m);
+}
+
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::Multiply(const BasicMatrix& a,
+                                        const BasicMatrix& b) {
+  if (a.cols_ != b.rows_ || a.rows_ == 0 || a.cols_ == 0 || b.rows_ == 0 ||
+      b.cols_ == 0) {
     throw std::logic_error(
         "MulMatrix: invalid matrix or different dimensions of the matrix");
   }
-  Matrix m(rows_, other.cols_);
-  for (std::size_t i = 0; i < m.rows_; i++) {
-    for (std::size_t j = 0; j < m.cols_; j++) {
-      for (std::size_t k = 0; k < cols_; k++) {
-        m.matrix_[i][j] += matrix_[i][k] * other.matrix_[k][j];
+  BasicMatrix m(a.rows_, b.cols_);
+  if (std::min({a.rows_, a.cols_, b.cols_}) >= kBlockedMulMinDimension) {
+    kernels::Gemm(kernels::Transpose::kNo, kernels::Transpose::kNo, a.rows_,
+                  b.cols_, a.cols_, 1, a.matrix_, a.cols_, b.matrix_, b.cols_,
+                  0, m.matrix_, m.cols_);
+  } else {
+    for (std::size_t i = 0; i < m.rows_; i++) {
+      T* row = m.matrix_ + i * m.cols_;
+      for (std::size_t k = 0; k < a.cols_; k++) {
+        const T factor = a.matrix_[i * a.cols_ + k];
+        const T* b_row = b.matrix_ + k * b.cols_;
+        for (std::size_t j = 0; j < m.cols_; j++) {
+          row[j] += factor * b_row[j];
+        }
       }
     }
   }
-  Swap(&m);
+  return m;
+}
+
+template <typename T>
+void BasicMatrix<T>::Gemv(const BasicMatrix& x, BasicMatrix* y) const {
+  if (rows_ == 0 || cols_ == 0 || x.GetSize() != cols_ || y == &x) {
+    throw std::logic_error("Gemv: invalid matrix or vector dimensions");
+  }
+  if (y->GetSize() != rows_) *y = BasicMatrix(rows_, 1);
+  kernels::Gemv(rows_, cols_, matrix_, cols_, x.matrix_, y->matrix_);
+}
+
+template <typename T>
+void BasicMatrix<T>::GemvTransposed(const BasicMatrix& x,
+                                    BasicMatrix* y) const {
+  if (rows_ == 0 || cols_ == 0 || x.GetSize() != rows_ || y == &x) {
+    throw std::logic_error(
+        "GemvTransposed: invalid matrix or vector dimensions");
+  }
+  if (y->GetSize() != cols_) *y = BasicMatrix(cols_, 1);
+  kernels::GemvTransposed(rows_, cols_, matrix_, cols_, x.matrix_,
+                          y->matrix_);
+}
+
+template <typename T>
+void BasicMatrix<T>::Ger(T alpha, const BasicMatrix& x, const BasicMatrix& y) {
+  if (rows_ == 0 || cols_ == 0 || x.GetSize() != rows_ ||
+      y.GetSize() != cols_) {
+    throw std::logic_error("Ger: invalid matrix or vector dimensions");
+  }
+  kernels::Ger(rows_, cols_, alpha, x.matrix_, y.matrix_, matrix_, cols_);
 }
 
-Matrix Matrix::Transpose() const {
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::Transpose() const {
   if (rows_ == 0 || cols_ == 0) {
     throw std::logic_error("Transpose: invalid matrix");
   }
-  Matrix m(cols_, rows_);
+  BasicMatrix m(cols_, rows_);
   for (std::size_t i = 0; i < m.rows_; i++) {
     for (std::size_t j = 0; j < m.cols_; j++) {
-      m.matrix_[i][j] = matrix_[j][i];
+      m.matrix_[i * m.cols_ + j] = matrix_[j * cols_ + i];
     }
   }
   return m;
 }
 
-Matrix Matrix::CalcComplements() const {
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::CalcComplements() const {
   if (rows_ != cols_ || rows_ == 0) {
     throw std::logic_error(
         "CalcComplements: invalid matrix or matrix is not square");
   }
-  Matrix m(cols_, rows_);
+  BasicMatrix m(cols_, rows_);
   if (rows_ > 1) {
-    Matrix t(rows_ - 1, cols_ - 1);
+    BasicMatrix t(rows_ - 1, cols_ - 1);
     for (std::size_t i = 0; i < m.rows_; i++) {
       for (std::size_t j = 0; j < m.cols_; j++) {
         unsigned int k_ = 0;
@@ -173,157 +228,176 @@ Matrix Matrix::CalcComplements() const {
           for (std::size_t l = 0; l < m.cols_; l++) {
             if (k == i) k_ = 1;
             if (l == j) l_ = 1;
-            if (k != i && l != j) t.matrix_[k - k_][l - l_] = matrix_[k][l];
+            if (k != i && l != j) t(k - k_, l - l_) = (*this)(k, l);
           }
         }
-        m.matrix_[i][j] = t.Determinant();
+        m(i, j) = t.Determinant();
         if ((i + j) % 2 != 0) {
-          m.matrix_[i][j] = -m.matrix_[i][j];
+          m(i, j) = -m(i, j);
         }
       }
     }
 
   } else {
-    m.matrix_[0][0] = matrix_[0][0];
+    m.matrix_[0] = matrix_[0];
   }
   return m;
 }
 
-double Matrix::Determinant() const {
+template <typename T>
+T BasicMatrix<T>::Determinant() const {
   if (rows_ != cols_ || rows_ == 0) {
     throw std::logic_error(
         "Determinant: invalid matrix or matrix is not square");
   }
-  double determinant = 1;
+  T determinant = 1;
 
-  Matrix m(*this);
+  BasicMatrix m(*this);
   for (std::size_t i = 0; i < m.cols_ && determinant != 0; i++) {
     if (m.DeterminantSwapRow(i)) {
       determinant = -determinant;
     }
-    if (m.matrix_[i][i] == 0) {
+    if (m(i, i) == 0) {
       determinant = 0;
     }
     for (auto j = i + 1; j < m.rows_ && determinant != 0; j++) {
-      double factor = -m.matrix_[j][i] / m.matrix_[i][i];
+      T factor = -m(j, i) / m(i, i);
       for (std::size_t k = 0; k < m.cols_; k++) {
-        m.matrix_[j][k] += m.matrix_[i][k] * factor;
+        m(j, k) += m(i, k) * factor;
       }
     }
   }
 
   for (std::size_t i = 0; i < m.cols_ && determinant != 0; i++) {
-    determinant *= m.matrix_[i][i];
+    determinant *= m(i, i);
   }
 
   return determinant;
 }
 
-bool Matrix::DeterminantSwapRow(std::size_t j) {
+template <typename T>
+bool BasicMatrix<T>::DeterminantSwapRow(std::size_t j) {
   std::size_t index = 0;
-  double max = 0;
+  T max = 0;
   for (auto i = j; i < rows_; i++) {
-    if (std::fabs(matrix_[i][j]) > max) {
+    if (std::fabs((*this)(i, j)) > max) {
       index = i;
-      max = std::fabs(matrix_[i][j]);
+      max = std::fabs((*this)(i, j));
     }
   }
 
   bool need_swap = j != index;
   if (need_swap) {
-    std::swap(matrix_[j], matrix_[index]);
+    std::swap_ranges(matrix_ + j * cols_, matrix_ + (j + 1) * cols_,
+                     matrix_ + index * cols_);
   }
   return need_swap;
 }
 
-Matrix Matrix::InverseMatrix() const {
-  double d = Determinant();
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::InverseMatrix() const {
+  T d = Determinant();
   if (d == 0) {
     throw std::runtime_error("InverseMatrix: matrix determinant is 0");
   }
-  Matrix complements = CalcComplements();
-  Matrix m = complements.Transpose();
-  for (std::size_t i = 0; i < m.rows_; i++) {
-    for (std::size_t j = 0; j < m.cols_; j++) {
-      m.matrix_[i][j] /= d;
-    }
+  BasicMatrix complements = CalcComplements();
+  BasicMatrix m = complements.Transpose();
+  for (std::size_t i = 0; i < m.GetSize(); i++) {
+    m.matrix_[i] /= d;
   }
   return m;
 }
 
-Matrix Matrix::operator+(const Matrix& other) const {
-  Matrix m(*this);
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::operator+(const BasicMatrix& other) const {
+  BasicMatrix m(*this);
   m.SumMatrix(other);
   return m;
 }
 
-Matrix Matrix::operator-(const Matrix& other) const {
-  Matrix m(*this);
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::operator-(const BasicMatrix& other) const {
+  BasicMatrix m(*this);
   m.SubMatrix(other);
   return m;
 }
 
-Matrix Matrix::operator*(const Matrix& other) const {
-  Matrix m(*this);
-  m.MulMatrix(other);
-  return m;
-}
-
-Matrix operator*(Matrix const& self, double number) {
-  Matrix m(self);
-  m.MulNumber(number);
-  return m;
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::operator*(const BasicMatrix& other) const {
+  return Multiply(*this, other);
 }
 
-Matrix operator*(double number, Matrix const& self) {
-  return operator*(self, number);
+template <typename T>
+bool BasicMatrix<T>::operator==(const BasicMatrix& other) const {
+  return EqMatrix(other);
 }
 
-bool Matrix::operator==(const Matrix& other) const { return EqMatrix(other); }
-
-Matrix& Matrix::operator=(const Matrix& other) {
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(const BasicMatrix& other) {
   if (this != &other) {
-    Matrix(other).Swap(this);
+    BasicMatrix(other).Swap(this);
   }
   return *this;
 }
 
-Matrix& Matrix::operator=(Matrix&& other) {
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(BasicMatrix&& other) {
   if (this != &other) {
-    Matrix(std::move(other)).Swap(this);
+    BasicMatrix(std::move(other)).Swap(this);
   }
   return *this;
 }
 
-Matrix& Matrix::operator+=(const Matrix& other) {
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator+=(const BasicMatrix& other) {
   SumMatrix(other);
   return *this;
 }
 
-Matrix& Matrix::operator-=(const Matrix& other) {
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator-=(const BasicMatrix& other) {
   SubMatrix(other);
   return *this;
 }
 
-Matrix& Matrix::operator*=(const Matrix& other) {
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator*=(const BasicMatrix& other) {
   MulMatrix(other);
   return *this;
 }
 
-Matrix& Matrix::operator*=(double const number) {
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator*=(T const number) {
   MulNumber(number);
   return *this;
 }
 
-double& Matrix::operator()(std::size_t i, std::size_t j) {
-  return const_cast<double&>(const_cast<const Matrix*>(this)->operator()(i, j));
+template <typename T>
+T& BasicMatrix<T>::operator()(std::size_t i, std::size_t j) {
+  return const_cast<T&>(const_cast<const BasicMatrix*>(this)->operator()(i, j));
 }
 
-double const& Matrix::operator()(std::size_t i, std::size_t j) const {
+template <typename T>
+T const& BasicMatrix<T>::operator()(std::size_t i, std::size_t j) const {
   if (i >= rows_ || j >= cols_) {
     throw std::out_of_range("operator(): i or j is out of range");
   }
-  return matrix_[i][j];
+  return matrix_[i * cols_ + j];
 }
 
+template <typename T>
+T* BasicMatrix<T>::Data() { return matrix_; }
+
+template <typename T>
+const T* BasicMatrix<T>::Data() const { return matrix_; }
+
+template <typename T>
+std::size_t BasicMatrix<T>::GetStride() const { return cols_; }
+
+template <typename T>
+std::size_t BasicMatrix<T>::GetSize() const { return rows_ * cols_; }
+
+template class BasicMatrix<double>;
+template class BasicMatrix<float>;
+
 }  // namespace s21
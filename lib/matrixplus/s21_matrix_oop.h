@@ -1,65 +1,107 @@
 #ifndef SRC_LIB_MATRIXPLUS_S21_MATRIX_OOP_H_
 #define SRC_LIB_MATRIXPLUS_S21_MATRIX_OOP_H_
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <memory>
+#include <new>
 #include <stdexcept>
 #include <string_view>
 #include <vector>
 
+#include "s21_gemm.h"
+#include "s21_kernels.h"
+
 namespace s21 {
 
-class Matrix {
+// Dense row-major matrix. Instantiated for double, the default precision of
+// the networks, and for float, their single-precision path.
+template <typename T>
+class BasicMatrix {
  public:
-  Matrix() = default;
-  Matrix(std::size_t rows, std::size_t cols);
-  Matrix(const Matrix& other);
-  Matrix(Matrix&& other);
-  explicit Matrix(const std::vector<double>& row);
-  ~Matrix();
+  BasicMatrix() = default;
+  BasicMatrix(std::size_t rows, std::size_t cols);
+  BasicMatrix(const BasicMatrix& other);
+  BasicMatrix(BasicMatrix&& other);
+  explicit BasicMatrix(const std::vector<T>& row);
+  ~BasicMatrix();
 
-  void Swap(Matrix* other);
+  void Swap(BasicMatrix* other);
 
   std::size_t GetRows() const;
   void SetRows(std::size_t rows);
   std::size_t GetColumns() const;
   void SetColumns(std::size_t cols);
 
-  bool EqMatrix(const Matrix& other) const;
-  void SumMatrix(const Matrix& other);
-  void SubMatrix(const Matrix& other);
-  void MulNumber(double number);
-  void MulMatrix(const Matrix& other);
-  Matrix Transpose() const;
-  Matrix CalcComplements() const;
-  double Determinant() const;
-  Matrix InverseMatrix() const;
-
-  Matrix operator+(const Matrix& other) const;
-  Matrix operator-(const Matrix& other) const;
-  Matrix operator*(const Matrix& other) const;
-  friend Matrix operator*(const Matrix& self, double number);
-  friend Matrix operator*(double number, const Matrix& self);
-  bool operator==(const Matrix& other) const;
-  Matrix& operator=(const Matrix& other);
-  Matrix& operator=(Matrix&& other);
-  Matrix& operator+=(const Matrix& other);
-  Matrix& operator-=(const Matrix& other);
-  Matrix& operator*=(const Matrix& other);
-  Matrix& operator*=(double number);
-  double& operator()(std::size_t i, std::size_t j);
-  const double& operator()(std::size_t i, std::size_t j) const;
+  bool EqMatrix(const BasicMatrix& other) const;
+  void SumMatrix(const BasicMatrix& other);
+  void SubMatrix(const BasicMatrix& other);
+  void MulNumber(T number);
+  void MulMatrix(const BasicMatrix& other);
+  BasicMatrix Transpose() const;
+  BasicMatrix CalcComplements() const;
+  T Determinant() const;
+  BasicMatrix InverseMatrix() const;
+
+  // Matrix-vector operations. Vectors are matrices with a single row or
+  // column; |y| is reshaped to a column only when its size does not match.
+  // y = A * x
+  void Gemv(const BasicMatrix& x, BasicMatrix* y) const;
+  // y = A^T * x, without forming the transpose
+  void GemvTransposed(const BasicMatrix& x, BasicMatrix* y) const;
+  // A += alpha * x * y^T, in place
+  void Ger(T alpha, const BasicMatrix& x, const BasicMatrix& y);
+
+  BasicMatrix operator+(const BasicMatrix& other) const;
+  BasicMatrix operator-(const BasicMatrix& other) const;
+  BasicMatrix operator*(const BasicMatrix& other) const;
+  friend BasicMatrix operator*(const BasicMatrix& self, T number) {
+    BasicMatrix m(self);
+    m.MulNumber(number);
+    return m;
+  }
+  friend BasicMatrix operator*(T number, const BasicMatrix& self) {
+    return self * number;
+  }
+  bool operator==(const BasicMatrix& other) const;
+  BasicMatrix& operator=(const BasicMatrix& other);
+  BasicMatrix& operator=(BasicMatrix&& other);
+  BasicMatrix& operator+=(const BasicMatrix& other);
+  BasicMatrix& operator-=(const BasicMatrix& other);
+  BasicMatrix& operator*=(const BasicMatrix& other);
+  BasicMatrix& operator*=(T number);
+  T& operator()(std::size_t i, std::size_t j);
+  const T& operator()(std::size_t i, std::size_t j) const;
+
+  // Raw row-major storage: element (i, j) lives at Data()[i * GetStride() + j].
+  T* Data();
+  const T* Data() const;
+  std::size_t GetStride() const;
+  std::size_t GetSize() const;
 
  private:
-  constexpr static const double kEps = 1e-7;
+  constexpr static const T kEps = static_cast<T>(1e-7);
+  constexpr static const std::size_t kAlignment = 64;
+  // Products with every dimension at least this large go through the blocked
+  // GEMM, smaller ones through a streaming i-k-j loop.
+  constexpr static const std::size_t kBlockedMulMinDimension = 16;
 
+  static T* Allocate(std::size_t size);
+  static void Deallocate(T* data);
+
+  static BasicMatrix Multiply(const BasicMatrix& a, const BasicMatrix& b);
   bool DeterminantSwapRow(std::size_t j);
 
   std::size_t rows_ = 0, cols_ = 0;
-  double** matrix_ = nullptr;
+  T* matrix_ = nullptr;
 };
 
+using Matrix = BasicMatrix<double>;
+
+extern template class BasicMatrix<double>;
+extern template class BasicMatrix<float>;
+
 }  // namespace s21
 
 #endif  // SRC_LIB_MATRIXPLUS_S21_MATRIX_OOP_H_
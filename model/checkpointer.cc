@@ -0,0 +1,123 @@
+#include "checkpointer.h"
+
+namespace s21 {
+
+Checkpointer::Checkpointer(CheckpointPolicy policy, std::string directory)
+    : policy_(policy), directory_(std::move(directory)) {
+  if (!directory_.empty() && directory_.back() != '/') directory_ += '/';
+  writer_ = std::thread(&Checkpointer::Work, this);
+}
+
+Checkpointer::~Checkpointer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  staged_.notify_one();
+  writer_.join();
+}
+
+// The slot being staged is never the one being written: the writer only
+// touches slot written_ % 2, and it differs from saved_ % 2 whenever a
+// snapshot is pending.
+void Checkpointer::Save(const NeuralNetwork& network, std::size_t epoch,
+                        std::size_t accuracy) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return saved_ - written_ < 2; });
+  Snapshot& snapshot = snapshots_[saved_ % 2];
+  lock.unlock();
+
+  const NetworkSettings& settings = network.GetSettings();
+  network.CopyWeights(&snapshot.weights);
+  snapshot.filename = directory_ + WeightWriter::GenerateFilename(
+                                       settings.number_of_hidden_layers,
+                                       epoch, accuracy);
+  snapshot.settings = settings;
+  snapshot.epoch = epoch;
+  snapshot.accuracy = accuracy;
+  snapshot.dtype = network.GetPrecision();
+
+  lock.lock();
+  saved_++;
+  lock.unlock();
+  staged_.notify_one();
+}
+
+void Checkpointer::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return written_ == saved_; });
+}
+
+std::vector<std::string> Checkpointer::GetFiles() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::string> files;
+  for (const Checkpoint& checkpoint : checkpoints_) {
+    files.push_back(checkpoint.filename);
+  }
+  return files;
+}
+
+// Stops only once everything staged has been written.
+void Checkpointer::Work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    staged_.wait(lock, [this] { return stop_ || written_ != saved_; });
+    if (written_ == saved_) return;
+    const Snapshot& snapshot = snapshots_[written_ % 2];
+    lock.unlock();
+
+    const bool written =
+        WeightWriter::Write(snapshot.filename, snapshot.weights,
+                            snapshot.settings, snapshot.epoch,
+                            snapshot.accuracy, snapshot.dtype);
+
+    lock.lock();
+    std::vector<std::string> expired;
+    if (written) {
+      checkpoints_.push_back({snapshot.filename, snapshot.accuracy});
+      expired = Retain();
+    }
+    lock.unlock();
+
+    // Save and Flush wait on the mutex, so files are deleted without it.
+    for (const std::string& file : expired) std::remove(file.c_str());
+
+    lock.lock();
+    written_++;
+    done_.notify_all();
+  }
+}
+
+std::vector<std::string> Checkpointer::Retain() {
+  if (policy_.keep_last == 0 && policy_.keep_best == 0) return {};
+
+  const std::size_t count = checkpoints_.size();
+  std::vector<bool> keep(count, false);
+  for (std::size_t i = count - std::min(count, policy_.keep_last); i < count;
+       i++) {
+    keep[i] = true;
+  }
+  std::vector<std::size_t> order(count);
+  for (std::size_t i = 0; i < count; i++) order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+                   [this](std::size_t a, std::size_t b) {
+                     return checkpoints_[a].accuracy > checkpoints_[b].accuracy;
+                   });
+  for (std::size_t i = 0; i < std::min(count, policy_.keep_best); i++) {
+    keep[order[i]] = true;
+  }
+
+  std::vector<Checkpoint> kept;
+  std::vector<std::string> expired;
+  for (std::size_t i = 0; i < count; i++) {
+    if (keep[i]) {
+      kept.push_back(std::move(checkpoints_[i]));
+    } else {
+      expired.push_back(std::move(checkpoints_[i].filename));
+    }
+  }
+  checkpoints_ = std::move(kept);
+  return expired;
+}
+
+}  // namespace s21
@@ -0,0 +1,89 @@
+#ifndef SRC_MODEL_CHECKPOINTER_H_
+#define SRC_MODEL_CHECKPOINTER_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "neural_network/io/weight_writer.h"
+#include "neural_network/neural_network.h"
+
+namespace s21 {
+
+// Which of the checkpoints written by one Checkpointer stay on disk: the
+// |keep_last| most recent ones and the |keep_best| most accurate ones, the
+// earlier checkpoint winning ties. With both 0 every checkpoint is kept.
+struct CheckpointPolicy {
+  std::size_t keep_last = 0;
+  std::size_t keep_best = 0;
+};
+
+// Saves weight checkpoints off the training thread. Save copies the weights
+// into one of two staging buffers and returns; a background thread writes
+// the buffer with WeightWriter (synced, atomic rename) and applies the
+// retention policy. Save only waits if both buffers are still being
+// written, i.e. when the disk is more than one checkpoint behind.
+class Checkpointer {
+ public:
+  // Files go to |directory|, or to the working directory if it is empty,
+  // under the names WeightWriter::GenerateFilename gives.
+  explicit Checkpointer(CheckpointPolicy policy = CheckpointPolicy(),
+                        std::string directory = "");
+  // Writes what is still staged before returning.
+  ~Checkpointer();
+
+  Checkpointer(const Checkpointer&) = delete;
+  Checkpointer& operator=(const Checkpointer&) = delete;
+
+  void Save(const NeuralNetwork& network, std::size_t epoch,
+            std::size_t accuracy);
+  // Waits until every saved checkpoint has been written.
+  void Flush();
+
+  // Checkpoints written and retained so far, oldest first.
+  std::vector<std::string> GetFiles() const;
+
+ private:
+  struct Snapshot {
+    std::string filename;
+    std::vector<double> weights;
+    NetworkSettings settings;
+    std::size_t epoch = 0;
+    std::size_t accuracy = 0;
+    Precision dtype = Precision::kDouble;
+  };
+  struct Checkpoint {
+    std::string filename;
+    std::size_t accuracy;
+  };
+
+  void Work();
+  // Drops the checkpoints |policy_| does not keep and returns their files,
+  // which the caller deletes once it has released |mutex_|. Called with
+  // |mutex_| held.
+  std::vector<std::string> Retain();
+
+  CheckpointPolicy policy_;
+  std::string directory_;
+
+  // Snapshot i % 2 is staged by the i-th Save; snapshots [written_, saved_)
+  // wait for the writer, the others are free.
+  Snapshot snapshots_[2];
+  std::size_t saved_ = 0;
+  std::size_t written_ = 0;
+  std::vector<Checkpoint> checkpoints_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable staged_;
+  std::condition_variable done_;
+  bool stop_ = false;
+  std::thread writer_;
+};
+
+}  // namespace s21
+
+#endif  // SRC_MODEL_CHECKPOINTER_H_
@@ -1,6 +1,7 @@
 #ifndef SRC_MODEL_CONFIGURATION_H_
 #define SRC_MODEL_CONFIGURATION_H_
 
+#include <cstdint>
 #include <string>
 
 #include "neural_network/network_interface.h"
@@ -16,6 +17,9 @@ class Configuration {
   NetworkType GetNetworkType() const { return network_type_; }
   void SetNetworkType(NetworkType type) { network_type_ = type; }
 
+  Precision GetPrecision() const { return precision_; }
+  void SetPrecision(Precision precision) { precision_ = precision; }
+
   std::size_t GetNumberOfHiddenLayers() const {
     return number_of_hidden_layers_;
   }
@@ -42,11 +46,38 @@ class Configuration {
   bool GetSaveWeightsEachEpoch() const { return save_weights_each_epoch_; }
   void SetSaveWeightsEachEpoch(bool value) { save_weights_each_epoch_ = value; }
 
+  // Epoch checkpoints of a training run that stay on disk: the last
+  // |keep_last| and the |keep_best| most accurate. Both 0, the default,
+  // keeps all of them.
+  std::size_t GetCheckpointKeepLast() const { return checkpoint_keep_last_; }
+  void SetCheckpointKeepLast(std::size_t count) {
+    checkpoint_keep_last_ = count;
+  }
+  std::size_t GetCheckpointKeepBest() const { return checkpoint_keep_best_; }
+  void SetCheckpointKeepBest(std::size_t count) {
+    checkpoint_keep_best_ = count;
+  }
+
   double GetLearningRate() const { return learning_rate_; }
   void SetLearningRate(double learning_rate) { learning_rate_ = learning_rate; }
 
+  std::size_t GetBatchSize() const { return batch_size_; }
+  void SetBatchSize(std::size_t batch_size) { batch_size_ = batch_size; }
+
+  std::size_t GetThreads() const { return threads_; }
+  void SetThreads(std::size_t threads) { threads_ = threads; }
+
+  TrainMode GetTrainMode() const { return train_mode_; }
+  void SetTrainMode(TrainMode mode) { train_mode_ = mode; }
+
+  // Seed of the initial weights of every network the model creates, so runs
+  // with the same seed and data are reproducible. 0 draws a fresh seed.
+  std::uint64_t GetSeed() const { return seed_; }
+  void SetSeed(std::uint64_t seed) { seed_ = seed; }
+
  private:
   NetworkType network_type_ = NetworkType::kMatrix;
+  Precision precision_ = Precision::kDouble;
   std::size_t number_of_hidden_layers_ = 4;
 
   TestType test_type_ = TestType::kWeight;
@@ -55,7 +86,13 @@ class Configuration {
 
   std::size_t epochs_ = 3;
   bool save_weights_each_epoch_ = true;
+  std::size_t checkpoint_keep_last_ = 0;
+  std::size_t checkpoint_keep_best_ = 0;
   double learning_rate_ = 0.15;
+  std::size_t batch_size_ = 1;
+  std::size_t threads_ = 1;
+  TrainMode train_mode_ = TrainMode::kSynchronous;
+  std::uint64_t seed_ = 0;
 };
 
 }  // namespace s21
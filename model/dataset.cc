@@ -0,0 +1,57 @@
+#include "dataset.h"
+
+namespace s21 {
+
+namespace {
+
+struct OwnedStorage {
+  std::vector<std::uint8_t> pixels;
+  std::vector<std::uint8_t> labels;
+};
+
+}  // namespace
+
+Dataset::Dataset(std::size_t image_size, std::vector<std::uint8_t> pixels,
+                 std::vector<std::uint8_t> labels)
+    : image_size_(image_size), count_(labels.size()) {
+  if (pixels.size() != count_ * image_size_) {
+    throw std::logic_error("pixel buffer does not match the image count");
+  }
+  auto storage = std::make_shared<OwnedStorage>(
+      OwnedStorage{std::move(pixels), std::move(labels)});
+  pixels_ = storage->pixels.data();
+  labels_ = storage->labels.data();
+  storage_ = std::move(storage);
+}
+
+Dataset::Dataset(std::shared_ptr<const void> storage, std::size_t image_size,
+                 std::size_t count, const std::uint8_t* pixels,
+                 const std::uint8_t* labels)
+    : storage_(std::move(storage)),
+      image_size_(image_size),
+      count_(count),
+      pixels_(pixels),
+      labels_(labels) {}
+
+Dataset Dataset::Subset(std::vector<std::size_t> indices) const {
+  if (indices_) {
+    for (std::size_t& index : indices) index = indices_->at(index);
+  }
+  for (std::size_t index : indices) {
+    if (index >= count_) throw std::out_of_range("image index out of range");
+  }
+  Dataset subset = *this;
+  subset.indices_ =
+      std::make_shared<const std::vector<std::size_t>>(std::move(indices));
+  return subset;
+}
+
+const std::uint8_t* Dataset::Pixels() const {
+  return indices_ ? nullptr : pixels_;
+}
+
+const std::uint8_t* Dataset::Labels() const {
+  return indices_ ? nullptr : labels_;
+}
+
+}  // namespace s21
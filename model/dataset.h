@@ -0,0 +1,96 @@
+#ifndef SRC_MODEL_DATASET_H_
+#define SRC_MODEL_DATASET_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace s21 {
+
+// One image of a Dataset: a label and a pointer to its 8-bit pixels. Valid for
+// as long as any Dataset sharing the storage is alive.
+class ImageView {
+ public:
+  ImageView(int number, const std::uint8_t* pixels, std::size_t size)
+      : number_(number), pixels_(pixels), size_(size) {}
+
+  int GetNumber() const { return number_; }
+  const std::uint8_t* Pixels() const { return pixels_; }
+  std::size_t GetSize() const { return size_; }
+
+ private:
+  int number_;
+  const std::uint8_t* pixels_;
+  std::size_t size_;
+};
+
+// Immutable set of equally sized 8-bit images: all pixels in one contiguous
+// row-major count x image_size buffer plus a parallel label array. The
+// storage is either owned or borrowed from a mapping (such as a dataset
+// cache) kept alive through a shared handle, so copies and subsets are cheap
+// and never duplicate pixels. A subset is a list of indices into its parent.
+class Dataset {
+ public:
+  class Iterator {
+   public:
+    Iterator(const Dataset* dataset, std::size_t index)
+        : dataset_(dataset), index_(index) {}
+
+    ImageView operator*() const { return (*dataset_)[index_]; }
+    Iterator& operator++() {
+      index_++;
+      return *this;
+    }
+    bool operator==(const Iterator& other) const {
+      return index_ == other.index_;
+    }
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+   private:
+    const Dataset* dataset_;
+    std::size_t index_;
+  };
+
+  Dataset() = default;
+  // Takes ownership of |pixels| (count x image_size) and |labels| (count).
+  Dataset(std::size_t image_size, std::vector<std::uint8_t> pixels,
+          std::vector<std::uint8_t> labels);
+  // Borrows |count| images from memory owned by |storage|.
+  Dataset(std::shared_ptr<const void> storage, std::size_t image_size,
+          std::size_t count, const std::uint8_t* pixels,
+          const std::uint8_t* labels);
+
+  std::size_t size() const { return indices_ ? indices_->size() : count_; }
+  bool empty() const { return size() == 0; }
+  std::size_t GetImageSize() const { return image_size_; }
+
+  ImageView operator[](std::size_t i) const {
+    std::size_t index = indices_ ? (*indices_)[i] : i;
+    return ImageView(labels_[index], pixels_ + index * image_size_,
+                     image_size_);
+  }
+  Iterator begin() const { return Iterator(this, 0); }
+  Iterator end() const { return Iterator(this, size()); }
+
+  // Images |indices| of this dataset, sharing its storage.
+  Dataset Subset(std::vector<std::size_t> indices) const;
+
+  // Pixels and labels of the underlying storage, in storage order, or
+  // nullptr for a subset, whose images are not contiguous.
+  const std::uint8_t* Pixels() const;
+  const std::uint8_t* Labels() const;
+
+ private:
+  std::shared_ptr<const void> storage_;
+  std::shared_ptr<const std::vector<std::size_t>> indices_;
+  std::size_t image_size_ = 0;
+  std::size_t count_ = 0;
+  const std::uint8_t* pixels_ = nullptr;
+  const std::uint8_t* labels_ = nullptr;
+};
+
+}  // namespace s21
+
+#endif  // SRC_MODEL_DATASET_H_
@@ -1,35 +1,18 @@
 #ifndef SRC_MODEL_IMAGE_H_
 #define SRC_MODEL_IMAGE_H_
 
-#include <algorithm>
-#include <vector>
-
 namespace s21 {
 
+// Geometry and value range of the 8-bit letter images. Pixels are stored raw
+// and scaled by 1 / kMaxValue only when they are fed to a network.
 class Image {
  public:
   static const int kWidthInPx = 28;
   static const int kHeightInPx = 28;
   constexpr static const double kMaxValue = 255.;
   static const int kSizeInPx = kWidthInPx * kHeightInPx;
-
-  Image() : char_number_(0) { data_.reserve(kSizeInPx); }
-  explicit Image(const std::vector<double>& data)
-      : char_number_(-1), data_(data) {}
-
-  int GetNumber() const { return char_number_; }
-  const std::vector<double>& GetData() const { return data_; }
-
-  void NormalizeData() {
-    std::transform(data_.begin(), data_.end(), data_.begin(),
-                   [](double d) -> double { return d / kMaxValue; });
-  }
-
- private:
-  friend class CsvReader;
-
-  int char_number_;
-  std::vector<double> data_;
+  // Labels run from 1 to kLetters.
+  static const int kLetters = 26;
 };
 
 }  // namespace s21
@@ -0,0 +1,66 @@
+#ifndef SRC_MODEL_IO_UTIL_H_
+#define SRC_MODEL_IO_UTIL_H_
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace s21::io {
+
+// Little-endian codec shared by the binary file formats: the values are
+// split into bytes explicitly, so the files are the same on every host.
+template <typename U>
+void StoreLe(U value, char* out) {
+  for (std::size_t i = 0; i < sizeof(U); i++) {
+    out[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+  }
+}
+
+template <typename U>
+U LoadLe(const char* data) {
+  U value = 0;
+  for (std::size_t i = 0; i < sizeof(U); i++) {
+    value |= static_cast<U>(static_cast<unsigned char>(data[i])) << (8 * i);
+  }
+  return value;
+}
+
+// Writes all |size| bytes, continuing after short writes and interrupted
+// calls. Returns false on any other error.
+inline bool WriteAll(int fd, const void* data, std::size_t size) {
+  const char* bytes = static_cast<const char*>(data);
+  while (size != 0) {
+    const ssize_t written = write(fd, bytes, size);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    bytes += written;
+    size -= static_cast<std::size_t>(written);
+  }
+  return true;
+}
+
+// Creates a new file with mode 0644 next to |path| and names it in
+// |temporary|; the name is unique, so concurrent writers of |path| never
+// share one. Returns its descriptor, or -1 if it could not be created.
+inline int CreateTemporary(const std::string& path, std::string* temporary) {
+  *temporary = path + ".XXXXXX";
+  const int fd = mkstemp(&(*temporary)[0]);
+  if (fd < 0) return -1;
+  if (fchmod(fd, 0644) != 0) {
+    close(fd);
+    std::remove(temporary->c_str());
+    return -1;
+  }
+  return fd;
+}
+
+}  // namespace s21::io
+
+#endif  // SRC_MODEL_IO_UTIL_H_
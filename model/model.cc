@@ -3,11 +3,13 @@
 namespace s21 {
 
 void Model::SetConfiguration(const Configuration& configuration) {
-  if (configuration.GetNetworkType() != configuration_.GetNetworkType() &&
+  if ((configuration.GetNetworkType() != configuration_.GetNetworkType() ||
+       configuration.GetPrecision() != configuration_.GetPrecision()) &&
       network_) {
     auto weights = network_->GetWeights();
     network_ = std::make_unique<NeuralNetwork>(configuration.GetNetworkType(),
-                                               network_->GetSettings());
+                                               network_->GetSettings(),
+                                               configuration.GetPrecision());
     network_->SetWeights(weights);
   }
   configuration_ = configuration;
@@ -19,14 +21,41 @@ void Model::SetWeights(
         success_callback,
     std::function<void(const std::string&)> error_callback) {
   try {
-    auto data = WeightReader::Read(filename);
-
-    network_ = std::make_unique<NeuralNetwork>(configuration_.GetNetworkType(),
-                                               data.settings);
-    network_->SetWeights(data.weights);
+    std::size_t epoch;
+    std::size_t accuracy;
+    if (WeightFile::HasMagic(filename)) {
+      // Version 2 files are mapped and checked once. A loaded network is
+      // only used for inference (Train builds a new one), so it runs
+      // straight on the mapping whenever that gives the configured
+      // network: always for int8 files, and for matrix networks stored in
+      // the configured precision. Writers replace weight files by rename,
+      // so the mapping never changes under the network.
+      auto file = std::make_shared<const WeightFile>(filename);
+      const std::uint32_t dtype = file->GetHeader().dtype;
+      if (dtype == WeightFile::kInt8 ||
+          (configuration_.GetNetworkType() == NetworkType::kMatrix &&
+           dtype == WeightFile::Dtype(configuration_.GetPrecision()))) {
+        network_ = std::make_unique<NeuralNetwork>(file);
+      } else {
+        network_ = std::make_unique<NeuralNetwork>(
+            configuration_.GetNetworkType(), file->GetSettings(),
+            configuration_.GetPrecision());
+        network_->SetWeights(file->ToDoubles());
+      }
+      epoch = file->GetHeader().epoch;
+      accuracy = file->GetHeader().accuracy;
+    } else {
+      auto data = WeightReader::Read(filename);
+      network_ = std::make_unique<NeuralNetwork>(
+          configuration_.GetNetworkType(), data.settings,
+          configuration_.GetPrecision());
+      network_->SetWeights(data.weights);
+      epoch = data.epoch;
+      accuracy = data.accuracy;
+    }
 
     if (success_callback)
-      success_callback(network_->GetSettings(), data.epoch, data.accuracy);
+      success_callback(network_->GetSettings(), epoch, accuracy);
   } catch (const std::runtime_error& e) {
     if (error_callback) error_callback(e.what());
   }
@@ -40,7 +69,6 @@ void Model::SetTrainDataset(
     std::thread([this, filename, success_callback, error_callback]() -> void {
       try {
         train_dataset_ = reader_->Read(filename);
-        NormalizeData(&train_dataset_);
         train_dataset_filename_ = filename;
 
         if (success_callback) success_callback(filename, train_dataset_.size());
@@ -61,7 +89,6 @@ void Model::SetTestDataset(
     std::thread([this, filename, success_callback, error_callback]() -> void {
       try {
         test_dataset_ = reader_->Read(filename);
-        NormalizeData(&test_dataset_);
         test_dataset_filename_ = filename;
 
         if (success_callback) success_callback(filename, test_dataset_.size());
@@ -81,7 +108,8 @@ void Model::Train(
     std::function<void()> test_start_callback,
     std::function<void(std::size_t)> test_progress_callback,
     std::function<void(NetworkTestMetrics, std::size_t)> test_end_callback,
-    std::function<void()> end_callback) {
+    std::function<void()> end_callback,
+    std::function<void(std::size_t, double)> throughput_callback) {
   if (train_dataset_.size() == 0)
     throw std::runtime_error("тренировочный набор данных отсутствует");
   if (test_dataset_.size() == 0)
@@ -90,19 +118,35 @@ void Model::Train(
   train_exit_flag_.exchange(false);
   std::thread th([this, start_callback, epoch_progress_callback,
                   epoch_end_callback, test_start_callback,
-                  test_progress_callback, test_end_callback,
-                  end_callback]() -> void {
+                  test_progress_callback, test_end_callback, end_callback,
+                  throughput_callback]() -> void {
+    SeedWeights();
     NetworkSettings settings;
     settings.number_of_hidden_layers = configuration_.GetNumberOfHiddenLayers();
     network_ = std::make_unique<NeuralNetwork>(configuration_.GetNetworkType(),
-                                               settings);
+                                               settings,
+                                               configuration_.GetPrecision());
+    network_->SetBatchSize(configuration_.GetBatchSize());
+    network_->SetThreads(configuration_.GetThreads());
+    network_->SetTrainMode(configuration_.GetTrainMode());
+    network_->SetThroughputCallback(throughput_callback);
+
+    // Epoch checkpoints are written by the checkpointer's own thread while
+    // the next epoch trains; they are all on disk before end_callback runs.
+    std::unique_ptr<Checkpointer> checkpointer;
+    if (configuration_.GetSaveWeightsEachEpoch()) {
+      CheckpointPolicy policy;
+      policy.keep_last = configuration_.GetCheckpointKeepLast();
+      policy.keep_best = configuration_.GetCheckpointKeepBest();
+      checkpointer = std::make_unique<Checkpointer>(policy);
+    }
 
     network_->Train(
         train_dataset_, configuration_.GetEpochs(),
         configuration_.GetLearningRate(), start_callback,
         epoch_progress_callback,
-        [this, test_start_callback, test_progress_callback, test_end_callback,
-         epoch_end_callback](std::size_t epoch) -> void {
+        [this, &checkpointer, test_start_callback, test_progress_callback,
+         test_end_callback, epoch_end_callback](std::size_t epoch) -> void {
           if (train_exit_flag_ == false) {
             auto metrics = network_->Test(
                 test_dataset_, 1, test_start_callback, test_progress_callback,
@@ -112,16 +156,18 @@ void Model::Train(
                 },
                 train_exit_flag_);
 
-            if (configuration_.GetSaveWeightsEachEpoch()) {
-              WeightWriter::Write(network_->GetWeights(),
-                                  network_->GetSettings(), epoch,
-                                  metrics.accuracy_percent);
+            if (checkpointer) {
+              checkpointer->Save(*network_, epoch, metrics.accuracy_percent);
             }
 
             if (epoch_end_callback) epoch_end_callback(epoch);
           }
         },
-        end_callback, train_exit_flag_);
+        [&checkpointer, end_callback]() -> void {
+          if (checkpointer) checkpointer->Flush();
+          if (end_callback) end_callback();
+        },
+        train_exit_flag_);
   });
   th.detach();
 }
@@ -149,75 +195,181 @@ void Model::StopTest() { test_exit_flag_.exchange(true); }
 void Model::TrainCrossValidation(
     std::size_t epochs, std::size_t k, std::function<void()> start_callback,
     std::function<void(std::size_t)> progress_callback,
-    std::function<void(NetworkTestMetrics)> end_callback) {
+    std::function<void(NetworkTestMetrics)> end_callback,
+    std::function<void(const CrossValidationMetrics&)> summary_callback) {
   if (train_dataset_.size() == 0)
     throw std::runtime_error("тренировочный набор данных отсутствует");
   // if (test_dataset_.size() == 0)
   //   throw std::runtime_error("тестовый набор данных отсутствует");
+  k = std::max<std::size_t>(k, 1);
 
   test_exit_flag_.exchange(false);
   std::thread th([this, epochs, k, start_callback, progress_callback,
-                  end_callback]() {
+                  end_callback, summary_callback]() {
     if (start_callback) start_callback();
 
-    std::unique_ptr<NeuralNetwork> network_cv;
-    std::unique_ptr<NeuralNetwork> network_best;
-    NetworkTestMetrics best_metrics;
-
     NetworkType type = configuration_.GetNetworkType();
     NetworkSettings settings;
     settings.number_of_hidden_layers = configuration_.GetNumberOfHiddenLayers();
 
-    size_t block_size = train_dataset_.size() / k;
-    // std::cout << block_size << std::endl;
-
-    // std::size_t prev_progress = std::string::npos;
-    for (std::size_t i = 0; i < k && !test_exit_flag_; i++) {
-      std::list<Image> test_data;
-      test_data.splice(test_data.begin(), train_dataset_,
-                       train_dataset_.begin(),
-                       std::next(train_dataset_.begin(), block_size));
-      network_cv = std::make_unique<NeuralNetwork>(type, settings);
-      network_cv->Train(train_dataset_, epochs,
-                        configuration_.GetLearningRate(), nullptr,
-                        progress_callback, nullptr, nullptr, test_exit_flag_);
-      NetworkTestMetrics metrics = network_cv->Test(
-          test_data, 1, nullptr, progress_callback, nullptr, test_exit_flag_);
-
-      if (metrics.fscore > best_metrics.fscore) {
-        best_metrics = metrics;
-        network_best = std::move(network_cv);
+    // Every network already shards its batches over the configured threads,
+    // so only as many folds run at once as leaves each of them its share.
+    const std::size_t threads =
+        std::max<std::size_t>(configuration_.GetThreads(), 1);
+    const std::size_t workers = std::clamp<std::size_t>(
+        std::thread::hardware_concurrency() / threads, 1, k);
+    const std::size_t size = train_dataset_.size();
+    const std::size_t block_size = size / k;
+
+    CrossValidationMetrics summary;
+    summary.folds.resize(k);
+    std::unique_ptr<NeuralNetwork> network_best;
+    std::atomic<std::size_t> next_fold(0);
+    // Progress counts finished epochs and tests over all folds.
+    const std::size_t stages = k * (epochs + 1);
+    std::size_t stages_done = 0;
+    std::mutex mutex;
+    auto stage_done = [&](std::size_t) {
+      std::lock_guard<std::mutex> lock(mutex);
+      stages_done++;
+      if (progress_callback) progress_callback(stages_done * 100 / stages);
+    };
+
+    ThreadPool pool(workers);
+    pool.Run([&](std::size_t) {
+      for (std::size_t i = next_fold++; i < k && !test_exit_flag_;
+           i = next_fold++) {
+        // Block i is the test fold; training runs over the blocks after it
+        // and then the ones before it. Both are index views over the shared
+        // training data, which is never modified.
+        std::vector<std::size_t> test_indices;
+        std::vector<std::size_t> train_indices;
+        train_indices.reserve(size - block_size);
+        for (std::size_t j = i * block_size; j < (i + 1) * block_size; j++) {
+          test_indices.push_back(j);
+        }
+        for (std::size_t j = (i + 1) * block_size; j < size; j++) {
+          train_indices.push_back(j);
+        }
+        for (std::size_t j = 0; j < i * block_size; j++) {
+          train_indices.push_back(j);
+        }
+        Dataset test_data = train_dataset_.Subset(std::move(test_indices));
+        Dataset train_data = train_dataset_.Subset(std::move(train_indices));
+
+        SeedWeights(i);
+        auto network = std::make_unique<NeuralNetwork>(
+            type, settings, configuration_.GetPrecision());
+        network->SetBatchSize(configuration_.GetBatchSize());
+        network->SetThreads(threads);
+        network->SetTrainMode(configuration_.GetTrainMode());
+        network->Train(train_data, epochs, configuration_.GetLearningRate(),
+                       nullptr, nullptr, stage_done, nullptr,
+                       test_exit_flag_);
+        NetworkTestMetrics metrics = network->Test(
+            test_data, 1, nullptr, nullptr, nullptr, test_exit_flag_);
+        stage_done(i);
+
+        // An undefined F-score (no positive answers) ranks last, and ties go
+        // to the lower fold, so the choice does not depend on which fold
+        // finished first.
+        auto score = [](const NetworkTestMetrics& m) {
+          return std::isnan(m.fscore) ? -1 : m.fscore;
+        };
+        std::lock_guard<std::mutex> lock(mutex);
+        summary.folds[i] = metrics;
+        const NetworkTestMetrics& best = summary.folds[summary.best_fold];
+        if (!network_best || score(metrics) > score(best) ||
+            (score(metrics) == score(best) && i < summary.best_fold)) {
+          summary.best_fold = i;
+          network_best = std::move(network);
+        }
       }
-      train_dataset_.splice(train_dataset_.end(), test_data);
-
-      // std::size_t progress = static_cast<std::size_t>(
-      //     static_cast<double>(i + 1) / static_cast<double>(k) * 100);
-      // if (progress_callback && prev_progress != progress) {
-      //   prev_progress = progress;
-      //   progress_callback(progress);
-      // }
+    });
+
+    NetworkTestMetrics best_metrics;
+    if (network_best) {
+      best_metrics = summary.folds[summary.best_fold];
+      network_ = std::move(network_best);
     }
+    if (summary_callback && !test_exit_flag_) {
+      Summarize(&summary);
+      summary_callback(summary);
+    }
+    if (end_callback) end_callback(best_metrics);
+  });
+  th.detach();
+}
 
-    network_ = std::move(network_best);
+void Model::Summarize(CrossValidationMetrics* metrics) {
+  NetworkTestMetrics& mean = metrics->mean;
+  NetworkTestMetrics& stddev = metrics->stddev;
+  mean = stddev = NetworkTestMetrics();
+  const double n = static_cast<double>(metrics->folds.size());
+  for (const NetworkTestMetrics& fold : metrics->folds) {
+    mean.accuracy += fold.accuracy / n;
+    mean.precision += fold.precision / n;
+    mean.recall += fold.recall / n;
+    mean.fscore += fold.fscore / n;
+    mean.time += fold.time / metrics->folds.size();
+  }
+  for (const NetworkTestMetrics& fold : metrics->folds) {
+    stddev.accuracy += std::pow(fold.accuracy - mean.accuracy, 2) / n;
+    stddev.precision += std::pow(fold.precision - mean.precision, 2) / n;
+    stddev.recall += std::pow(fold.recall - mean.recall, 2) / n;
+    stddev.fscore += std::pow(fold.fscore - mean.fscore, 2) / n;
+  }
+  stddev.accuracy = std::sqrt(stddev.accuracy);
+  stddev.precision = std::sqrt(stddev.precision);
+  stddev.recall = std::sqrt(stddev.recall);
+  stddev.fscore = std::sqrt(stddev.fscore);
+  mean.accuracy_percent = static_cast<std::size_t>(mean.accuracy * 100);
+  stddev.accuracy_percent = static_cast<std::size_t>(stddev.accuracy * 100);
+}
 
-    if (end_callback) end_callback(best_metrics);
+void Model::Quantize(
+    const std::string& filename, std::size_t calibration_samples,
+    std::function<void(NetworkTestMetrics, NetworkTestMetrics)>
+        success_callback,
+    std::function<void(const std::string&)> error_callback) {
+  if (!IsNetworkCreated()) throw std::runtime_error("веса сети отсутствуют");
+  if (test_dataset_.size() == 0)
+    throw std::runtime_error("тестовый набор данных отсутствует");
+
+  std::thread th([this, filename, calibration_samples, success_callback,
+                  error_callback]() -> void {
+    try {
+      QuantizedNetwork quantized = QuantizedNetwork::Quantize(
+          network_->GetWeights(), network_->GetSettings(), test_dataset_,
+          calibration_samples);
+      if (!quantized.Save(filename))
+        throw std::runtime_error("не удалось сохранить файл весов");
+
+      // The saved file is tested, so the metrics cover what gets deployed.
+      NeuralNetwork deployed(std::make_shared<const WeightFile>(filename));
+      NetworkTestMetrics reference = network_->Test(test_dataset_, 1);
+      NetworkTestMetrics metrics = deployed.Test(test_dataset_, 1);
+      if (success_callback) success_callback(reference, metrics);
+    } catch (const std::runtime_error& e) {
+      if (error_callback) error_callback(e.what());
+    }
   });
   th.detach();
 }
 
-char Model::AnalyzeRawImage(const std::vector<double>& data) {
+void Model::SeedWeights(std::uint64_t stream) const {
+  if (configuration_.GetSeed() != 0) {
+    utility::SeedRandom(configuration_.GetSeed() ^
+                        (stream * 0x9e3779b97f4a7c15));
+  }
+}
+
+char Model::AnalyzeRawImage(const std::vector<std::uint8_t>& data) {
   char letter = 0;
   if (IsNetworkCreated()) {
-    auto image = Image(data);
-    image.NormalizeData();
-    letter = static_cast<char>(Predict(image).first);
+    letter = static_cast<char>(network_->Infer(data.data(), data.size()).first);
   }
   return static_cast<char>(letter) + 'A';
 }
 
-void Model::NormalizeData(std::list<Image>* images) {
-  std::for_each(images->begin(), images->end(),
-                [](Image& image) -> void { image.NormalizeData(); });
-}
-
 }  // namespace s21
@@ -1,10 +1,13 @@
 #ifndef SRC_MODEL_MODEL_H_
 #define SRC_MODEL_MODEL_H_
 
+#include <algorithm>
 #include <atomic>
 #include <iostream>
 #include <memory>
+#include <mutex>
 
+#include "checkpointer.h"
 #include "configuration.h"
 #include "neural_network/io/weight_reader.h"
 #include "neural_network/neural_network.h"
@@ -41,6 +44,9 @@ class Model {
 
   bool IsNetworkCreated() { return network_ != nullptr; }
 
+  // Trains a new network on a background thread. In Hogwild mode
+  // throughput_callback gets every worker's index and samples per second once
+  // per epoch, called from the worker threads.
   void Train(std::function<void()> start_callback = nullptr,
              std::function<void(std::size_t)> epoch_progress_callback = nullptr,
              std::function<void(std::size_t)> epoch_end_callback = nullptr,
@@ -48,7 +54,9 @@ class Model {
              std::function<void(std::size_t)> test_progress_callback = nullptr,
              std::function<void(NetworkTestMetrics, std::size_t)>
                  test_end_callback = nullptr,
-             std::function<void()> end_callback = nullptr);
+             std::function<void()> end_callback = nullptr,
+             std::function<void(std::size_t, double)> throughput_callback =
+                 nullptr);
 
   void StopTrain();
 
@@ -58,28 +66,52 @@ class Model {
 
   void StopTest();
 
+  // Trains k networks concurrently, each tested on its own block of the
+  // training data, and keeps the one with the best F-score. end_callback gets
+  // the metrics of that network; summary_callback, if the run was not
+  // stopped, gets those of all folds with their mean and spread.
   void TrainCrossValidation(
       std::size_t epochs, std::size_t k,
       std::function<void()> start_callback = nullptr,
       std::function<void(std::size_t)> progress_callback = nullptr,
-      std::function<void(NetworkTestMetrics)> end_callback = nullptr);
+      std::function<void(NetworkTestMetrics)> end_callback = nullptr,
+      std::function<void(const CrossValidationMetrics&)> summary_callback =
+          nullptr);
 
-  std::pair<int, double> Predict(const Image& image) {
+  std::pair<int, double> Predict(const ImageView& image) {
     return network_->Predict(image);
   }
 
-  char AnalyzeRawImage(const std::vector<double>& data);
+  char AnalyzeRawImage(const std::vector<std::uint8_t>& data);
+
+  // Quantizes the current network to int8 on a background thread, with input
+  // scales calibrated on up to |calibration_samples| test images, and saves
+  // it to |filename|. success_callback gets the metrics of the current
+  // network and of the saved one on the whole test dataset; failures go to
+  // error_callback. Throws if there is no network or test dataset. Loading
+  // the file with SetWeights runs it on the int8 kernels.
+  void Quantize(
+      const std::string& filename, std::size_t calibration_samples,
+      std::function<void(NetworkTestMetrics, NetworkTestMetrics)>
+          success_callback = nullptr,
+      std::function<void(const std::string&)> error_callback = nullptr);
 
  private:
-  void NormalizeData(std::list<Image>* images);
+  // Seeds the weight generator of the calling thread from the configuration
+  // before it builds networks; distinct |stream|s give independent weights
+  // for networks built side by side. Does nothing for seed 0.
+  void SeedWeights(std::uint64_t stream = 0) const;
+  // Fills in the mean and the population standard deviation of the folds.
+  static void Summarize(CrossValidationMetrics* metrics);
 
-  std::unique_ptr<BaseFileReader> reader_ = std::make_unique<CsvReader>();
+  std::unique_ptr<BaseFileReader> reader_ =
+      std::make_unique<CsvReader>(std::thread::hardware_concurrency(), true);
 
   std::string train_dataset_filename_;
-  std::list<Image> train_dataset_;
+  Dataset train_dataset_;
 
   std::string test_dataset_filename_;
-  std::list<Image> test_dataset_;
+  Dataset test_dataset_;
 
   Configuration configuration_;
   std::unique_ptr<NeuralNetwork> network_;
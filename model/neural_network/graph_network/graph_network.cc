@@ -2,71 +2,115 @@
 
 namespace s21 {
 
-GraphNetwork::GraphNetwork(NetworkSettings settings) {
-  layers_.push_back(std::make_unique<Layer>(settings.neurons_in_input_layer));
+template <typename T>
+BasicGraphNetwork<T>::BasicGraphNetwork(NetworkSettings settings) {
+  layers_.push_back(
+      std::make_unique<BasicLayer<T>>(settings.neurons_in_input_layer));
 
   for (std::size_t i = 0; i < settings.number_of_hidden_layers; i++) {
-    layers_.push_back(std::make_unique<Layer>(settings.neurons_in_hidden_layer,
-                                              layers_.back()));
+    layers_.push_back(std::make_unique<BasicLayer<T>>(
+        settings.neurons_in_hidden_layer, layers_.back()));
   }
 
-  layers_.push_back(std::make_unique<Layer>(settings.neurons_in_output_layer,
-                                            layers_.back()));
+  layers_.push_back(std::make_unique<BasicLayer<T>>(
+      settings.neurons_in_output_layer, layers_.back()));
+
+  for (const auto &layer : layers_) {
+    infer_.emplace_back(layer->Outputs().size());
+  }
 }
 
-void GraphNetwork::BackPropagation(const std::vector<double> &expected_output,
-                                   double learning_rate_) {
-  std::vector<double> error = layers_.back()->Error(expected_output);
+template <typename T>
+void BasicGraphNetwork<T>::BackPropagation(
+    const std::vector<double> &expected_output, double learning_rate_) {
+  const std::vector<T> *error = &layers_.back()->Error(expected_output);
 
   for (std::size_t layer = layers_.size() - 1; layer != 0; layer--) {
-    error = layers_.at(layer)->AdjustWeights(learning_rate_, error);
+    error = &layers_.at(layer)->AdjustWeights(learning_rate_, *error);
   }
 }
 
-void GraphNetwork::SetInput(const std::vector<double> &outputs) {
+template <typename T>
+void BasicGraphNetwork<T>::SetInput(const std::vector<double> &outputs) {
   layers_.front()->SetOutput(outputs);
 }
 
-void GraphNetwork::ForwardPropagation() {
+template <typename T>
+void BasicGraphNetwork<T>::SetScaledInput(const std::uint8_t *input,
+                                          double scale) {
+  layers_.front()->SetOutput(input, scale);
+}
+
+template <typename T>
+void BasicGraphNetwork<T>::ForwardPropagation() {
   for (auto &layer : layers_) {
     layer->CalculateOutput();
   }
 }
 
-std::vector<double> GraphNetwork::GetOutput() {
-  std::vector<double> output;
+template <typename T>
+std::vector<double> BasicGraphNetwork<T>::GetOutput() {
+  const std::vector<T> &outputs = layers_.back()->Outputs();
+  return std::vector<double>(outputs.begin(), outputs.end());
+}
 
-  auto neurons = layers_.back()->Neurons();
-  std::transform(neurons.begin(), neurons.end(), std::back_inserter(output),
-                 [](const Neuron &n) { return n.GetOutput(); });
+template <typename T>
+void BasicGraphNetwork<T>::CopyOutput(double *output) const {
+  const std::vector<T> &outputs = layers_.back()->Outputs();
+  std::copy(outputs.begin(), outputs.end(), output);
+}
 
-  return output;
+// The layers hold the activations, so samples go through one at a time.
+template <typename T>
+void BasicGraphNetwork<T>::PredictBatch(std::size_t /*worker*/,
+                                        const std::uint8_t *const *inputs,
+                                        std::size_t count, double scale,
+                                        double *outputs) {
+  const std::size_t output_size = layers_.back()->Outputs().size();
+  for (std::size_t b = 0; b < count; b++) {
+    SetScaledInput(inputs[b], scale);
+    ForwardPropagation();
+    CopyOutput(outputs + b * output_size);
+  }
 }
 
-std::vector<double> GraphNetwork::GetWeights() {
+template <typename T>
+void BasicGraphNetwork<T>::Infer(const std::uint8_t *input, double scale,
+                                 double *output) {
+  kernels::ScaleBytes(infer_.front().size(), static_cast<T>(scale), input,
+                      infer_.front().data());
+  for (std::size_t i = 1; i < layers_.size(); i++) {
+    layers_[i]->CalculateOutput(infer_[i - 1].data(), infer_[i].data());
+  }
+  std::copy(infer_.back().begin(), infer_.back().end(), output);
+}
+
+template <typename T>
+std::vector<double> BasicGraphNetwork<T>::GetWeights() {
   std::vector<double> weights;
+  CopyWeights(&weights);
+  return weights;
+}
 
+template <typename T>
+void BasicGraphNetwork<T>::CopyWeights(std::vector<double> *weights) {
+  weights->clear();
   for (const auto &l : layers_) {
-    for (const auto &n : l->Neurons()) {
-      std::for_each(n.GetConnections().begin(), n.GetConnections().end(),
-                    [&weights](const std::pair<Neuron *, double> &el) -> void {
-                      weights.push_back(el.second);
-                    });
-    }
+    weights->insert(weights->end(), l->Weights().begin(), l->Weights().end());
   }
-
-  return weights;
 }
 
-void GraphNetwork::LoadWeights(const std::vector<double> &weights) {
+template <typename T>
+void BasicGraphNetwork<T>::LoadWeights(const std::vector<double> &weights) {
   std::size_t i = 0;
-  for (auto &l : layers_)
-    for (auto &n : l->Neurons())
-      for (auto &p : n.GetConnections()) {
-        p.second = weights[i++];
-      }
-
-  return;
+  for (auto &l : layers_) {
+    std::copy_n(weights.begin() + static_cast<std::ptrdiff_t>(i),
+                l->Weights().size(), l->Weights().begin());
+    i += l->Weights().size();
+  }
 }
 
+template class BasicGraphNetwork<double>;
+template class BasicGraphNetwork<float>;
+
 }  // namespace s21
@@ -10,24 +10,41 @@
 
 namespace s21 {
 
-class GraphNetwork : public NetworkInterface {
+template <typename T>
+class BasicGraphNetwork : public NetworkInterface {
  public:
-  explicit GraphNetwork(NetworkSettings settings);
-  ~GraphNetwork() = default;
+  explicit BasicGraphNetwork(NetworkSettings settings);
+  ~BasicGraphNetwork() = default;
 
   void SetInput(const std::vector<double>& outputs) override;
+  void SetScaledInput(const std::uint8_t* input, double scale) override;
   void BackPropagation(const std::vector<double>& expected_output,
                        double learning_rate_) override;
   void ForwardPropagation() override;
   std::vector<double> GetOutput() override;
+  void CopyOutput(double* output) const override;
+  void PredictBatch(std::size_t worker, const std::uint8_t* const* inputs,
+                    std::size_t count, double scale,
+                    double* outputs) override;
+  void Infer(const std::uint8_t* input, double scale,
+             double* output) override;
 
   std::vector<double> GetWeights() override;
+  void CopyWeights(std::vector<double>* weights) override;
   void LoadWeights(const std::vector<double>& weights) override;
 
  private:
-  std::vector<std::unique_ptr<Layer>> layers_;
+  std::vector<std::unique_ptr<BasicLayer<T>>> layers_;
+  // Activations of every layer for Infer, which leaves the ones stored in
+  // the layers to training.
+  std::vector<std::vector<T>> infer_;
 };
 
+using GraphNetwork = BasicGraphNetwork<double>;
+
+extern template class BasicGraphNetwork<double>;
+extern template class BasicGraphNetwork<float>;
+
 }  // namespace s21
 
 #endif  // SRC_MODEL_NEURAL_NETWORK_GRAPH_NETWORK_GRAPH_NETWORK_H_
@@ -2,68 +2,113 @@
 
 namespace s21 {
 
-Layer::Layer(unsigned long number_of_neurons) : type_(LayerType::kInput) {
-  for (std::size_t i = 0; i < number_of_neurons; i++) {
-    neurons_.emplace_back(0);
-  }
+template <typename T>
+BasicLayer<T>::BasicLayer(unsigned long number_of_neurons)
+    : type_(LayerType::kInput),
+      outputs_(number_of_neurons, 0),
+      biases_(number_of_neurons, 0),
+      deltas_(number_of_neurons, 0),
+      errors_(number_of_neurons, 0) {
+  MakeNeurons();
 }
 
-Layer::Layer(unsigned long number_of_neurons,
-             const std::unique_ptr<Layer>& prev_layer)
-    : type_(LayerType::kOutput) {
+template <typename T>
+BasicLayer<T>::BasicLayer(unsigned long number_of_neurons,
+                          const std::unique_ptr<BasicLayer>& prev_layer)
+    : type_(LayerType::kOutput),
+      prev_layer_(prev_layer.get()),
+      number_of_inputs_(prev_layer->outputs_.size()),
+      outputs_(number_of_neurons, 0),
+      biases_(number_of_neurons, 0),
+      deltas_(number_of_neurons, 0),
+      weights_(number_of_neurons * number_of_inputs_),
+      errors_(number_of_neurons, 0),
+      input_errors_(number_of_inputs_, 0) {
   if (prev_layer->type_ == LayerType::kOutput)
     prev_layer->SetLayerType(LayerType::kHidden);
 
-  for (std::size_t i = 0; i < number_of_neurons; i++) {
-    neurons_.emplace_back(prev_layer->Neurons());
+  utility::FillRandom(weights_.data(), weights_.size());
+  MakeNeurons();
+}
+
+template <typename T>
+void BasicLayer<T>::MakeNeurons() {
+  const T* inputs = prev_layer_ ? prev_layer_->outputs_.data() : nullptr;
+  for (std::size_t i = 0; i < outputs_.size(); i++) {
+    neurons_.emplace_back(&outputs_[i], &biases_[i],
+                          weights_.data() + i * number_of_inputs_, inputs,
+                          number_of_inputs_);
   }
 }
 
-std::vector<Neuron>& Layer::Neurons() { return neurons_; }
+template <typename T>
+std::vector<BasicNeuron<T>>& BasicLayer<T>::Neurons() { return neurons_; }
 
-LayerType Layer::GetLayerType() { return type_; }
+template <typename T>
+LayerType BasicLayer<T>::GetLayerType() { return type_; }
 
-void Layer::SetLayerType(LayerType type) { type_ = type; }
+template <typename T>
+void BasicLayer<T>::SetLayerType(LayerType type) { type_ = type; }
 
-void Layer::CalculateOutput() {
+template <typename T>
+void BasicLayer<T>::CalculateOutput() {
   if (type_ == LayerType::kInput) return;
+  CalculateOutput(prev_layer_->outputs_.data(), outputs_.data());
+}
 
-  for (Neuron& neuron : neurons_) {
-    neuron.CalcOutput();
-  }
+template <typename T>
+void BasicLayer<T>::CalculateOutput(const T* inputs, T* outputs) const {
+  kernels::Gemv(outputs_.size(), number_of_inputs_, weights_.data(),
+                number_of_inputs_, inputs, outputs);
+  kernels::Axpy(outputs_.size(), 1, biases_.data(), outputs);
+  kernels::Sigmoid(outputs_.size(), outputs, outputs);
 }
 
-std::vector<double> Layer::AdjustWeights(double learning_rate,
-                                         std::vector<double> errors) {
-  std::vector<double> input_errors(neurons_.at(0).connections_.size(), 0);
-  for (std::size_t i = 0; i < neurons_.size(); i++) {
-    double delta = neurons_.at(i).Delta(errors.at(i));
-    double delta_coef = delta * learning_rate;
-
-    int j = 0;
-    for (auto& [prev_neuron, weight] : neurons_.at(i).connections_) {
-      weight = weight - (prev_neuron->GetOutput() * delta_coef);
-      input_errors.at(j) += delta * weight;
-      j++;
-    }
-    neurons_.at(i).bias_ -= delta_coef;
+// Each neuron's row is updated first and then contributes its updated
+// weights to the errors of the previous layer.
+template <typename T>
+const std::vector<T>& BasicLayer<T>::AdjustWeights(
+    double learning_rate, const std::vector<T>& errors) {
+  std::copy_n(errors.begin(), deltas_.size(), deltas_.begin());
+  kernels::MulSigmoidDerivative(deltas_.size(), outputs_.data(),
+                                deltas_.data());
+
+  std::fill(input_errors_.begin(), input_errors_.end(), T(0));
+  const T* inputs = prev_layer_->outputs_.data();
+  for (std::size_t i = 0; i < deltas_.size(); i++) {
+    T delta_coef = deltas_[i] * static_cast<T>(learning_rate);
+    T* row = weights_.data() + i * number_of_inputs_;
+    kernels::Axpy(number_of_inputs_, -delta_coef, inputs, row);
+    kernels::Axpy(number_of_inputs_, deltas_[i], row, input_errors_.data());
+    biases_[i] -= delta_coef;
   }
 
-  return input_errors;
+  return input_errors_;
 }
 
-std::vector<double> Layer::Error(const std::vector<double>& expected_output) {
-  std::vector<double> error;
-  for (std::size_t i = 0; i < neurons_.size(); i++) {
-    error.push_back(neurons_[i].GetOutput() - expected_output[i]);
+template <typename T>
+const std::vector<T>& BasicLayer<T>::Error(
+    const std::vector<double>& expected_output) {
+  for (std::size_t i = 0; i < outputs_.size(); i++) {
+    errors_[i] = static_cast<T>(outputs_[i] - expected_output[i]);
   }
-  return error;
+  return errors_;
 }
 
-void Layer::SetOutput(const std::vector<double>& outputs) {
-  for (std::size_t i = 0; i < neurons_.size(); i++) {
-    neurons_[i].SetOutput(outputs.at(i));
+template <typename T>
+void BasicLayer<T>::SetOutput(const std::vector<double>& outputs) {
+  for (std::size_t i = 0; i < outputs_.size(); i++) {
+    outputs_[i] = static_cast<T>(outputs.at(i));
   }
 }
 
+template <typename T>
+void BasicLayer<T>::SetOutput(const std::uint8_t* outputs, double scale) {
+  kernels::ScaleBytes(outputs_.size(), static_cast<T>(scale), outputs,
+                      outputs_.data());
+}
+
+template class BasicLayer<double>;
+template class BasicLayer<float>;
+
 }  // namespace s21
@@ -8,32 +8,69 @@
 namespace s21 {
 
 enum class LayerType { kInput = 0, kHidden, kOutput };
-class Layer {
+
+// Stores its neurons as parallel arrays (outputs, biases, deltas) and their
+// incoming weights as one row-major block, row i belonging to neuron i, so
+// the passes run as dense kernels instead of walking individual connections.
+// The neurons returned by Neurons() point into these arrays, so a layer is
+// neither copyable nor movable. T is the storage and compute precision; the
+// inputs and expected outputs coming from the network stay double.
+template <typename T>
+class BasicLayer {
  public:
-  explicit Layer(unsigned long number_of_neurons);
-  Layer(unsigned long number_of_neurons,
-        const std::unique_ptr<Layer>& prev_layer);
-  ~Layer() = default;
+  explicit BasicLayer(unsigned long number_of_neurons);
+  BasicLayer(unsigned long number_of_neurons,
+             const std::unique_ptr<BasicLayer>& prev_layer);
+  ~BasicLayer() = default;
+
+  BasicLayer(const BasicLayer&) = delete;
+  BasicLayer& operator=(const BasicLayer&) = delete;
 
   LayerType GetLayerType();
 
-  std::vector<Neuron>& Neurons();
+  std::vector<BasicNeuron<T>>& Neurons();
+  const std::vector<T>& Outputs() const { return outputs_; }
+  // Row-major, one row of GetNumberOfInputs() weights per neuron.
+  std::vector<T>& Weights() { return weights_; }
+  std::size_t GetNumberOfInputs() const { return number_of_inputs_; }
 
   void SetOutput(const std::vector<double>& outputs);
+  // Sets output i to scale * outputs[i] for every neuron of the layer.
+  void SetOutput(const std::uint8_t* outputs, double scale);
   void CalculateOutput();
+  // Computes the layer's outputs for the previous layer's |inputs| into
+  // |outputs| without touching the activations stored in the layer.
+  void CalculateOutput(const T* inputs, T* outputs) const;
 
-  std::vector<double> AdjustWeights(double learning_rate,
-                                    std::vector<double> errors);
-  std::vector<double> Error(const std::vector<double>& expected_output);
+  // Both return a buffer owned by the layer that stays valid until the next
+  // call, so backpropagation does not allocate.
+  const std::vector<T>& AdjustWeights(double learning_rate,
+                                      const std::vector<T>& errors);
+  const std::vector<T>& Error(const std::vector<double>& expected_output);
 
  private:
   void SetLayerType(LayerType type);
-  void CalculateDelta();
+  void MakeNeurons();
 
   LayerType type_;
-  std::vector<Neuron> neurons_;
+  const BasicLayer* prev_layer_ = nullptr;
+  std::size_t number_of_inputs_ = 0;
+
+  std::vector<T> outputs_;
+  std::vector<T> biases_;
+  std::vector<T> deltas_;
+  std::vector<T> weights_;
+  std::vector<BasicNeuron<T>> neurons_;
+  // Output-layer error and the errors passed down to the previous layer.
+  std::vector<T> errors_;
+  std::vector<T> input_errors_;
 };
 
+using Layer = BasicLayer<double>;
+
+extern template class BasicLayer<double>;
+extern template class BasicLayer<float>;
+
 }  // namespace s21
 
 #endif  //  SRC_MODEL_NEURAL_NETWORK_GRAPH_NETWORK_LAYER_H_
@@ -2,47 +2,44 @@
 
 namespace s21 {
 
-Neuron::Neuron(double out) : output_(out) {}
-
-Neuron::Neuron(const std::map<Neuron *, double> &connections)
-    : connections_(connections) {}
-
-Neuron::Neuron(std::vector<Neuron> &neurons) {
-  for (Neuron &neuron : neurons) {
-    AddRandomWeight(&neuron);
-  }
-}
-
-void Neuron::SetOutput(double out) { output_ = out; }
-
-double Neuron::GetOutput() const { return output_; }
-
-void Neuron::SetConnections(const std::map<Neuron *, double> &connections) {
-  connections_ = connections;
+template <typename T>
+BasicNeuron<T>::BasicNeuron(T *output, T *bias, T *weights, const T *inputs,
+                            std::size_t number_of_inputs)
+    : output_(output),
+      bias_(bias),
+      weights_(weights),
+      inputs_(inputs),
+      number_of_inputs_(number_of_inputs) {}
+
+template <typename T>
+void BasicNeuron<T>::SetOutput(T out) { *output_ = out; }
+
+template <typename T>
+T BasicNeuron<T>::GetOutput() const { return *output_; }
+
+template <typename T>
+T BasicNeuron<T>::GetBias() const { return *bias_; }
+
+template <typename T>
+std::size_t BasicNeuron<T>::GetNumberOfWeights() const {
+  return number_of_inputs_;
 }
 
-std::map<Neuron *, double> &Neuron::GetConnections() { return connections_; }
-
-const std::map<Neuron *, double> &Neuron::GetConnections() const {
-  return connections_;
-}
-
-void Neuron::AddRandomWeight(Neuron *neuron) {
-  connections_[neuron] = utility::RandomWeight();
-}
+template <typename T>
+T BasicNeuron<T>::GetWeight(std::size_t i) const { return weights_[i]; }
 
-void Neuron::CalcOutput() {
-  double out = bias_;
-  for (auto [prev_neuron, weight] : connections_) {
-    out += weight * prev_neuron->GetOutput();
-  }
-  output_ = ActivationFunc(out);
+template <typename T>
+void BasicNeuron<T>::SetWeight(std::size_t i, T weight) {
+  weights_[i] = weight;
 }
 
-double Neuron::Delta(double error) {
-  return (utility::DerivativeActivFunc(output_) * error);
+template <typename T>
+void BasicNeuron<T>::CalcOutput() {
+  T out = *bias_ + kernels::Dot(number_of_inputs_, weights_, inputs_);
+  *output_ = static_cast<T>(utility::ActivationFunc(out));
 }
 
-double Neuron::ActivationFunc(double x) { return utility::ActivationFunc(x); }
+template class BasicNeuron<double>;
+template class BasicNeuron<float>;
 
 }  // namespace s21
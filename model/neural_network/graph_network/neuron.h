@@ -2,40 +2,48 @@
 #define SRC_MODEL_NEURAL_NETWORK_GRAPH_NETWORK_NEURON_H_
 
 #include <algorithm>
-#include <map>
+#include <cstddef>
 #include <vector>
 
+#include "../../../lib/matrixplus/s21_kernels.h"
 #include "../utility.h"
 
 namespace s21 {
 
-class Neuron {
+// A neuron is a view of one ordinal of its layer: the output, bias and delta
+// live in the layer's parallel arrays and the incoming weights are one row of
+// the layer's row-major weight block. Copies refer to the same neuron.
+template <typename T>
+class BasicNeuron {
  public:
-  Neuron() = default;
-  explicit Neuron(double out);
-  explicit Neuron(const std::map<Neuron*, double>& connections);
-  explicit Neuron(std::vector<Neuron>& neurons);
-  ~Neuron() = default;
-
-  void SetOutput(double out);
-  double GetOutput() const;
-  void SetConnections(const std::map<Neuron*, double>& connections);
-  std::map<Neuron*, double>& GetConnections();
-  const std::map<Neuron*, double>& GetConnections() const;
-
-  void AddRandomWeight(Neuron* neuron);
+  BasicNeuron() = default;
+  BasicNeuron(T* output, T* bias, T* weights, const T* inputs,
+              std::size_t number_of_inputs);
+  ~BasicNeuron() = default;
+
+  void SetOutput(T out);
+  T GetOutput() const;
+  T GetBias() const;
+
+  // Weight of the connection from neuron |i| of the previous layer.
+  std::size_t GetNumberOfWeights() const;
+  T GetWeight(std::size_t i) const;
+  void SetWeight(std::size_t i, T weight);
+
   void CalcOutput();
 
  private:
-  double Delta(double error);
-  double ActivationFunc(double x);
+  T* output_ = nullptr;
+  T* bias_ = nullptr;
+  T* weights_ = nullptr;
+  const T* inputs_ = nullptr;
+  std::size_t number_of_inputs_ = 0;
+};
 
-  double bias_ = 0;
-  double output_ = 0;
-  std::map<Neuron*, double> connections_;
+using Neuron = BasicNeuron<double>;
 
-  friend class Layer;
-};
+extern template class BasicNeuron<double>;
+extern template class BasicNeuron<float>;
 
 }  // namespace s21
 
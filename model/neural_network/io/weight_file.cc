@@ -0,0 +1,259 @@
+#include "weight_file.h"
+
+namespace s21 {
+
+namespace {
+
+const char kMagic[8] = {'S', '2', '1', 'M', 'L', 'P', 'W', '\0'};
+
+constexpr bool kLittleEndianHost =
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+
+using io::LoadLe;
+using io::StoreLe;
+
+// Copies |count| little-endian values of type T from |data| to |out| as
+// doubles.
+template <typename T, typename U>
+void LoadValues(const char* data, std::size_t count, double* out) {
+  static_assert(sizeof(T) == sizeof(U), "T and U must have the same size");
+  for (std::size_t i = 0; i < count; i++) {
+    T value;
+    if (kLittleEndianHost) {
+      std::memcpy(&value, data + i * sizeof(T), sizeof(T));
+    } else {
+      U bits = LoadLe<U>(data + i * sizeof(T));
+      std::memcpy(&value, &bits, sizeof(T));
+    }
+    out[i] = value;
+  }
+}
+
+// Stores |count| doubles from |values| as little-endian values of type T.
+template <typename T, typename U>
+void StoreValues(const double* values, std::size_t count, char* out) {
+  static_assert(sizeof(T) == sizeof(U), "T and U must have the same size");
+  for (std::size_t i = 0; i < count; i++) {
+    const T value = static_cast<T>(values[i]);
+    if (kLittleEndianHost) {
+      std::memcpy(out + i * sizeof(T), &value, sizeof(T));
+    } else {
+      U bits;
+      std::memcpy(&bits, &value, sizeof(T));
+      StoreLe(bits, out + i * sizeof(T));
+    }
+  }
+}
+
+// Rounds |size| up to the alignment of the payload.
+std::size_t AlignUp(std::size_t size) {
+  return (size + WeightFile::kPayloadOffset - 1) / WeightFile::kPayloadOffset *
+         WeightFile::kPayloadOffset;
+}
+
+}  // namespace
+
+bool WeightFile::HasMagic(const char* data, std::size_t size) {
+  return size >= sizeof(kMagic) &&
+         std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool WeightFile::HasMagic(const std::string& filename) {
+  char data[sizeof(kMagic)] = {};
+  std::ifstream file(filename, std::ifstream::binary);
+  file.read(data, sizeof(data));
+  return HasMagic(data, static_cast<std::size_t>(file.gcount()));
+}
+
+void WeightFile::Encode(const Header& header, char* out) {
+  std::memcpy(out, kMagic, sizeof(kMagic));
+  StoreLe(header.version, out + 8);
+  StoreLe(header.dtype, out + 12);
+  StoreLe(header.hidden_layers, out + 16);
+  StoreLe(header.input_neurons, out + 20);
+  StoreLe(header.hidden_neurons, out + 24);
+  StoreLe(header.output_neurons, out + 28);
+  StoreLe(header.epoch, out + 32);
+  StoreLe(header.accuracy, out + 40);
+  StoreLe(header.weight_count, out + 48);
+  StoreLe(header.checksum, out + 56);
+}
+
+WeightFile::Header WeightFile::Decode(const char* data) {
+  Header header;
+  header.version = LoadLe<std::uint32_t>(data + 8);
+  header.dtype = LoadLe<std::uint32_t>(data + 12);
+  header.hidden_layers = LoadLe<std::uint32_t>(data + 16);
+  header.input_neurons = LoadLe<std::uint32_t>(data + 20);
+  header.hidden_neurons = LoadLe<std::uint32_t>(data + 24);
+  header.output_neurons = LoadLe<std::uint32_t>(data + 28);
+  header.epoch = LoadLe<std::uint64_t>(data + 32);
+  header.accuracy = LoadLe<std::uint64_t>(data + 40);
+  header.weight_count = LoadLe<std::uint64_t>(data + 48);
+  header.checksum = LoadLe<std::uint64_t>(data + 56);
+  return header;
+}
+
+std::uint64_t WeightFile::Checksum(const void* data, std::size_t size) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  std::uint64_t hash = 0xcbf29ce484222325;
+  for (std::size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3;
+  }
+  return hash;
+}
+
+std::size_t WeightFile::DtypeSize(std::uint32_t dtype) {
+  switch (dtype) {
+    case kFloat64:
+      return sizeof(double);
+    case kFloat32:
+      return sizeof(float);
+    case kInt8:
+      return sizeof(std::int8_t);
+    default:
+      return 0;
+  }
+}
+
+std::uint32_t WeightFile::Dtype(Precision precision) {
+  return precision == Precision::kFloat ? kFloat32 : kFloat64;
+}
+
+NetworkSettings WeightFile::Settings(const Header& header) {
+  NetworkSettings settings;
+  settings.number_of_hidden_layers = header.hidden_layers;
+  settings.neurons_in_input_layer = header.input_neurons;
+  settings.neurons_in_hidden_layer = header.hidden_neurons;
+  settings.neurons_in_output_layer = header.output_neurons;
+  return settings;
+}
+
+WeightFile::Header WeightFile::MakeHeader(const NetworkSettings& settings,
+                                          std::uint32_t dtype) {
+  Header header;
+  header.dtype = dtype;
+  header.hidden_layers =
+      static_cast<std::uint32_t>(settings.number_of_hidden_layers);
+  header.input_neurons =
+      static_cast<std::uint32_t>(settings.neurons_in_input_layer);
+  header.hidden_neurons =
+      static_cast<std::uint32_t>(settings.neurons_in_hidden_layer);
+  header.output_neurons =
+      static_cast<std::uint32_t>(settings.neurons_in_output_layer);
+  header.weight_count = WeightCount(settings);
+  return header;
+}
+
+std::size_t WeightFile::WeightCount(const NetworkSettings& settings) {
+  if (settings.number_of_hidden_layers == 0) return 0;
+  const std::size_t hidden = settings.neurons_in_hidden_layer;
+  return hidden * settings.neurons_in_input_layer +
+         (settings.number_of_hidden_layers - 1) * hidden * hidden +
+         settings.neurons_in_output_layer * hidden;
+}
+
+std::size_t WeightFile::ScaleCount(const NetworkSettings& settings) {
+  return settings.number_of_hidden_layers + 1 +
+         settings.number_of_hidden_layers * settings.neurons_in_hidden_layer +
+         settings.neurons_in_output_layer;
+}
+
+std::size_t WeightFile::QuantizedWeightsOffset(
+    const NetworkSettings& settings) {
+  return AlignUp(ScaleCount(settings) * sizeof(float));
+}
+
+std::size_t WeightFile::PayloadSize(const Header& header) {
+  const std::size_t weights = header.weight_count * DtypeSize(header.dtype);
+  if (header.dtype != kInt8) return weights;
+  return QuantizedWeightsOffset(Settings(header)) + weights;
+}
+
+// The weights are read on every pass, so the whole file is paged in up front.
+WeightFile::WeightFile(const std::string& filename)
+    : file_(filename, MADV_WILLNEED) {
+  if (!HasMagic(file_.Data(), file_.Size()) ||
+      file_.Size() < kPayloadOffset) {
+    throw std::runtime_error("некорректный формат файла");
+  }
+  header_ = Decode(file_.Data());
+  if (header_.version != kVersion) {
+    throw std::runtime_error("неподдерживаемая версия файла весов");
+  }
+  if (DtypeSize(header_.dtype) == 0 || header_.hidden_layers == 0 ||
+      header_.weight_count != WeightCount(GetSettings()) ||
+      PayloadSize(header_) > file_.Size() - kPayloadOffset) {
+    throw std::runtime_error("некорректный формат файла");
+  }
+  if (Checksum(Payload(), PayloadSize(header_)) != header_.checksum) {
+    throw std::runtime_error("файл весов повреждён");
+  }
+}
+
+std::vector<double> WeightFile::ToDoubles() const {
+  std::vector<double> weights(header_.weight_count);
+  const char* payload = file_.Data() + kPayloadOffset;
+  if (header_.dtype == kInt8) {
+    const NetworkSettings settings = GetSettings();
+    const std::vector<float> scales = Scales();
+    const std::int8_t* quantized = reinterpret_cast<const std::int8_t*>(
+        payload + QuantizedWeightsOffset(settings));
+    // Row scales follow the layer input scales.
+    const float* row_scale =
+        scales.data() + settings.number_of_hidden_layers + 1;
+    std::size_t columns = settings.neurons_in_input_layer;
+    std::size_t i = 0;
+    for (std::size_t l = 0; l <= settings.number_of_hidden_layers; l++) {
+      const std::size_t rows = l < settings.number_of_hidden_layers
+                                   ? settings.neurons_in_hidden_layer
+                                   : settings.neurons_in_output_layer;
+      for (std::size_t r = 0; r < rows; r++, row_scale++) {
+        for (std::size_t c = 0; c < columns; c++, i++) {
+          weights[i] = static_cast<float>(quantized[i]) * *row_scale;
+        }
+      }
+      columns = rows;
+    }
+  } else if (header_.dtype == kFloat32) {
+    LoadValues<float, std::uint32_t>(payload, weights.size(), weights.data());
+  } else {
+    LoadValues<double, std::uint64_t>(payload, weights.size(),
+                                      weights.data());
+  }
+  return weights;
+}
+
+std::vector<float> WeightFile::Scales() const {
+  std::vector<double> values(ScaleCount(GetSettings()));
+  LoadValues<float, std::uint32_t>(file_.Data() + kPayloadOffset,
+                                   values.size(), values.data());
+  return std::vector<float>(values.begin(), values.end());
+}
+
+std::vector<char> WeightFile::EncodePayload(const std::vector<double>& weights,
+                                            std::uint32_t dtype) {
+  std::vector<char> payload(weights.size() * DtypeSize(dtype));
+  if (dtype == kFloat32) {
+    StoreValues<float, std::uint32_t>(weights.data(), weights.size(),
+                                      payload.data());
+  } else {
+    StoreValues<double, std::uint64_t>(weights.data(), weights.size(),
+                                       payload.data());
+  }
+  return payload;
+}
+
+std::vector<char> WeightFile::EncodeQuantizedPayload(
+    const std::vector<float>& scales,
+    const std::vector<std::int8_t>& weights) {
+  const std::size_t offset = AlignUp(scales.size() * sizeof(float));
+  std::vector<char> payload(offset + weights.size());
+  const std::vector<double> values(scales.begin(), scales.end());
+  StoreValues<float, std::uint32_t>(values.data(), values.size(),
+                                    payload.data());
+  std::memcpy(payload.data() + offset, weights.data(), weights.size());
+  return payload;
+}
+
+}  // namespace s21
@@ -0,0 +1,108 @@
+#ifndef SRC_MODEL_NEURAL_NETWORK_IO_WEIGHT_FILE_H_
+#define SRC_MODEL_NEURAL_NETWORK_IO_WEIGHT_FILE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../../io_util.h"
+#include "../../reader/mapped_file.h"
+#include "../network_interface.h"
+
+namespace s21 {
+
+// Version 2 weight file:
+//
+//   Header (64 bytes, little-endian)
+//   payload: weight_count values of |dtype|, little-endian IEEE 754
+//
+// The payload starts right after the header, at a 64-byte boundary, in the
+// order of NetworkInterface::GetWeights, so a mapped file can be used in
+// place. The checksum is FNV-1a over the payload bytes. Version 1 files
+// (SCHOOL21 signature, raw NetworkSettings, native doubles) are handled by
+// WeightReader only.
+//
+// A kInt8 payload holds a quantized network: ScaleCount float32 scales, zero
+// padding up to QuantizedWeightsOffset, then the int8 weights. The scales
+// are the input scale of every layer followed by the scale of every weight
+// row, layer by layer; weight q of a row stands for q * row scale.
+class WeightFile {
+ public:
+  static constexpr std::uint32_t kVersion = 2;
+  static constexpr std::uint32_t kFloat64 = 1;
+  static constexpr std::uint32_t kFloat32 = 2;
+  static constexpr std::uint32_t kInt8 = 3;
+  static constexpr std::size_t kPayloadOffset = 64;
+
+  // In-memory form of the header. Encode and Decode convert it from and to
+  // the little-endian layout, so it never depends on the host.
+  struct Header {
+    std::uint32_t version = kVersion;
+    std::uint32_t dtype = kFloat64;
+    // Layer shapes, as in NetworkSettings.
+    std::uint32_t hidden_layers = 0;
+    std::uint32_t input_neurons = 0;
+    std::uint32_t hidden_neurons = 0;
+    std::uint32_t output_neurons = 0;
+    std::uint64_t epoch = 0;
+    std::uint64_t accuracy = 0;
+    std::uint64_t weight_count = 0;
+    std::uint64_t checksum = 0;
+  };
+
+  // True for the first bytes of a version 2 file, whatever its version.
+  static bool HasMagic(const char* data, std::size_t size);
+  // The same for the start of the file |filename|; false if it cannot be
+  // read.
+  static bool HasMagic(const std::string& filename);
+  static void Encode(const Header& header, char* out);
+  static Header Decode(const char* data);
+  static std::uint64_t Checksum(const void* data, std::size_t size);
+
+  static std::size_t DtypeSize(std::uint32_t dtype);
+  static std::uint32_t Dtype(Precision precision);
+  static NetworkSettings Settings(const Header& header);
+  // Header of a network with |settings| stored as |dtype|.
+  static Header MakeHeader(const NetworkSettings& settings,
+                           std::uint32_t dtype);
+  // Number of weights a network with |settings| stores.
+  static std::size_t WeightCount(const NetworkSettings& settings);
+  // Number of scales and offset of the weights in a kInt8 payload.
+  static std::size_t ScaleCount(const NetworkSettings& settings);
+  static std::size_t QuantizedWeightsOffset(const NetworkSettings& settings);
+  static std::size_t PayloadSize(const Header& header);
+
+  // Maps |filename| and validates header, size and checksum. Throws
+  // std::runtime_error if the file is not a valid version 2 weight file.
+  explicit WeightFile(const std::string& filename);
+
+  const Header& GetHeader() const { return header_; }
+  NetworkSettings GetSettings() const { return Settings(header_); }
+  // weight_count values of the header dtype, 64-byte aligned. Valid while
+  // the object lives.
+  const void* Payload() const { return file_.Data() + kPayloadOffset; }
+  // The weights converted to double; kInt8 weights are dequantized.
+  std::vector<double> ToDoubles() const;
+  // The scales of a kInt8 file.
+  std::vector<float> Scales() const;
+
+  // Payload bytes of |weights| stored as |dtype|, which must not be kInt8.
+  static std::vector<char> EncodePayload(const std::vector<double>& weights,
+                                         std::uint32_t dtype);
+  // Payload bytes of a quantized network.
+  static std::vector<char> EncodeQuantizedPayload(
+      const std::vector<float>& scales,
+      const std::vector<std::int8_t>& weights);
+
+ private:
+  MappedFile file_;
+  Header header_;
+};
+
+}  // namespace s21
+
+#endif  // SRC_MODEL_NEURAL_NETWORK_IO_WEIGHT_FILE_H_
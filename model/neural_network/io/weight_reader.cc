@@ -3,31 +3,57 @@
 namespace s21 {
 
 WeightReader::Data WeightReader::Read(const std::string& filename) {
-  Data data;
   std::ifstream file(filename, std::ifstream::binary);
-  if (file.is_open()) {
-    char signature[sizeof(WeightWriter::kSignature)];
-    file.read(reinterpret_cast<char*>(signature), sizeof(signature));
+  if (!file.is_open()) throw std::runtime_error("файл не найден");
 
-    if (std::string(signature) == WeightWriter::kSignature) {
-      file.read(reinterpret_cast<char*>(&data.settings),
-                sizeof(NetworkSettings));
+  char signature[sizeof(WeightWriter::kSignature)] = {};
+  file.read(signature, sizeof(signature));
+  const std::size_t read = static_cast<std::size_t>(file.gcount());
+  if (WeightFile::HasMagic(signature, read)) {
+    file.close();
+    WeightFile weight_file(filename);
+    const WeightFile::Header& header = weight_file.GetHeader();
+    Data data;
+    data.settings = weight_file.GetSettings();
+    data.epoch = header.epoch;
+    data.accuracy = header.accuracy;
+    data.dtype = header.dtype == WeightFile::kFloat64 ? Precision::kDouble
+                                                      : Precision::kFloat;
+    data.quantized = header.dtype == WeightFile::kInt8;
+    data.weights = weight_file.ToDoubles();
+    return data;
+  }
+  if (read != sizeof(signature) ||
+      std::memcmp(signature, WeightWriter::kSignature, sizeof(signature)) !=
+          0) {
+    throw std::runtime_error("некорректный формат файла");
+  }
+  return ReadVersion1(file);
+}
 
-      file.read(reinterpret_cast<char*>(&data.epoch), sizeof(data.epoch));
-      file.read(reinterpret_cast<char*>(&data.accuracy), sizeof(data.accuracy));
+// Version 1 stored NetworkSettings, epoch and accuracy as native 64-bit
+// words followed by native doubles up to the end of the file. The rest of the
+// file is read with a single call.
+WeightReader::Data WeightReader::ReadVersion1(std::ifstream& file) {
+  std::uint64_t fields[6];
+  file.read(reinterpret_cast<char*>(fields), sizeof(fields));
+  if (!file) throw std::runtime_error("некорректный формат файла");
 
-      double d;
-      while (file.read(reinterpret_cast<char*>(&d), sizeof(d))) {
-        data.weights.push_back(d);
-      }
-      file.close();
-    } else {
-      throw std::runtime_error("некорректный формат файла");
-    }
-  } else {
-    throw std::runtime_error("файл не найден");
-  }
+  Data data;
+  data.settings.number_of_hidden_layers = fields[0];
+  data.settings.neurons_in_input_layer = fields[1];
+  data.settings.neurons_in_hidden_layer = fields[2];
+  data.settings.neurons_in_output_layer = fields[3];
+  data.epoch = fields[4];
+  data.accuracy = fields[5];
 
+  const std::streamoff start = file.tellg();
+  file.seekg(0, std::ifstream::end);
+  const std::streamoff end = file.tellg();
+  file.seekg(start);
+  data.weights.resize(static_cast<std::size_t>(end - start) / sizeof(double));
+  file.read(reinterpret_cast<char*>(data.weights.data()),
+            static_cast<std::streamsize>(data.weights.size() * sizeof(double)));
   return data;
 }
 
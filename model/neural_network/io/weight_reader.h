@@ -6,18 +6,26 @@
 
 namespace s21 {
 
+// Reads version 2 files (see WeightFile) and the version 1 files they
+// replaced. Weights always come back as double; |dtype| records how they
+// were stored. Quantized files come back dequantized, as kFloat.
 class WeightReader {
  public:
   struct Data {
     NetworkSettings settings;
     std::size_t epoch;
     std::size_t accuracy;
+    Precision dtype = Precision::kDouble;
+    bool quantized = false;
     std::vector<double> weights;
   };
 
   WeightReader() = delete;
 
   static Data Read(const std::string& filename);
+
+ private:
+  static Data ReadVersion1(std::ifstream& file);
 };
 
 }  // namespace s21
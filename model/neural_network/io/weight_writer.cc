@@ -2,18 +2,19 @@
 
 namespace s21 {
 
-void WeightWriter::Write(const std::string& filename,
+bool WeightWriter::Write(const std::string& filename,
                          const std::vector<double>& weights,
                          const NetworkSettings& settings, std::size_t epoch,
-                         std::size_t accuracy) {
-  Write_(filename, weights, settings, epoch, accuracy);
+                         std::size_t accuracy, Precision dtype) {
+  return Write_(filename, weights, settings, epoch, accuracy, dtype);
 }
 
-void WeightWriter::Write(const std::vector<double>& weights,
+bool WeightWriter::Write(const std::vector<double>& weights,
                          NetworkSettings settings, std::size_t epoch,
-                         std::size_t accuracy) {
-  Write_(GenerateFilename(settings.number_of_hidden_layers, epoch, accuracy),
-         weights, settings, epoch, accuracy);
+                         std::size_t accuracy, Precision dtype) {
+  return Write_(
+      GenerateFilename(settings.number_of_hidden_layers, epoch, accuracy),
+      weights, settings, epoch, accuracy, dtype);
 }
 
 std::string WeightWriter::GenerateFilename(std::size_t layers,
@@ -35,28 +36,48 @@ std::string WeightWriter::GenerateFilename(std::size_t layers,
   return ss.str();
 }
 
-void WeightWriter::Write_(const std::string& filename,
+// The payload is encoded into one buffer and written with a single call.
+bool WeightWriter::Write_(const std::string& filename,
                           const std::vector<double>& weights,
                           const NetworkSettings& settings, std::size_t epoch,
-                          std::size_t accuracy) {
-  std::ofstream file(filename, std::ofstream::app);
-  if (file.is_open()) {
-    file.clear();
-
-    file.write(kSignature, sizeof(kSignature));
-
-    file.write(reinterpret_cast<const char*>(&settings),
-               sizeof(NetworkSettings));
-
-    file.write(reinterpret_cast<const char*>(&epoch), sizeof(epoch));
-    file.write(reinterpret_cast<const char*>(&accuracy), sizeof(accuracy));
+                          std::size_t accuracy, Precision dtype) {
+  WeightFile::Header header =
+      WeightFile::MakeHeader(settings, WeightFile::Dtype(dtype));
+  header.epoch = epoch;
+  header.accuracy = accuracy;
+  header.weight_count = weights.size();
+  return Write(filename, header,
+               WeightFile::EncodePayload(weights, header.dtype));
+}
 
-    for (auto w : weights) {
-      file.write(reinterpret_cast<char*>(&w), sizeof(w));
-    }
+// Syncing the file before the rename and the directory after it makes the
+// new file durable before the old one disappears.
+bool WeightWriter::Write(const std::string& filename, WeightFile::Header header,
+                         const std::vector<char>& payload) {
+  header.checksum = WeightFile::Checksum(payload.data(), payload.size());
+  char encoded[WeightFile::kPayloadOffset];
+  WeightFile::Encode(header, encoded);
+  std::string temporary;
+  int fd = io::CreateTemporary(filename, &temporary);
+  if (fd < 0) return false;
+  bool written = io::WriteAll(fd, encoded, sizeof(encoded)) &&
+                 io::WriteAll(fd, payload.data(), payload.size()) &&
+                 fsync(fd) == 0;
+  written = close(fd) == 0 && written;
+  if (!written || std::rename(temporary.c_str(), filename.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    return false;
+  }
 
-    file.close();
+  const std::size_t slash = filename.rfind('/');
+  const std::string directory =
+      slash == std::string::npos ? "." : filename.substr(0, slash + 1);
+  int directory_fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+  if (directory_fd >= 0) {
+    fsync(directory_fd);
+    close(directory_fd);
   }
+  return true;
 }
 
 }  // namespace s21
@@ -1,6 +1,10 @@
 #ifndef SRC_MODEL_NEURAL_NETWORK_IO_WEIGHT_WRITER_H_
 #define SRC_MODEL_NEURAL_NETWORK_IO_WEIGHT_WRITER_H_
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
 #include <ctime>
 #include <fstream>
 #include <iomanip>
@@ -9,34 +13,52 @@
 #include <vector>
 
 #include "../network_interface.h"
+#include "weight_file.h"
 
 namespace s21 {
 
+// Writes version 2 weight files (see WeightFile), storing the weights as
+// |dtype|: kFloat halves the file and matches a float network exactly.
+//
+// A file is written under a temporary name, synced and renamed over the
+// target, so readers and mappings of the old file never see a partial one.
+// Write returns false if the file could not be written, leaving any
+// existing file untouched.
 class WeightWriter {
  public:
-  static void Write(const std::string& filename,
+  static bool Write(const std::string& filename,
                     const std::vector<double>& weights,
                     const NetworkSettings& settings,
                     std::size_t epoch = std::string::npos,
-                    std::size_t accuracy = std::string::npos);
+                    std::size_t accuracy = std::string::npos,
+                    Precision dtype = Precision::kDouble);
 
-  static void Write(const std::vector<double>& weights,
+  static bool Write(const std::vector<double>& weights,
                     NetworkSettings settings,
                     std::size_t epoch = std::string::npos,
-                    std::size_t accuracy = std::string::npos);
+                    std::size_t accuracy = std::string::npos,
+                    Precision dtype = Precision::kDouble);
+
+  // Writes an already encoded payload; the checksum of |header| is filled
+  // in. Used for payloads EncodePayload does not produce, such as kInt8.
+  static bool Write(const std::string& filename, WeightFile::Header header,
+                    const std::vector<char>& payload);
+
+  // mlp_l<layers>_e<epoch>_a<accuracy>_<local time>.bin; npos parts are
+  // left out.
+  static std::string GenerateFilename(std::size_t layers, std::size_t epoch,
+                                      std::size_t accuracy);
 
  private:
+  // Signature of version 1 files, which are still read.
   constexpr static const char kSignature[] = {"SCHOOL21"};
 
   friend class WeightReader;
 
-  static std::string GenerateFilename(std::size_t layers, std::size_t epoch,
-                                      std::size_t accuracy);
-
-  static void Write_(const std::string& filename,
+  static bool Write_(const std::string& filename,
                      const std::vector<double>& weights,
                      const NetworkSettings& settings, std::size_t epoch,
-                     std::size_t accuracy);
+                     std::size_t accuracy, Precision dtype);
 };
 
 }  // namespace s21
@@ -0,0 +1,148 @@
+#include "mapped_network.h"
+
+namespace s21 {
+
+template <typename T>
+MappedNetwork<T>::MappedNetwork(std::shared_ptr<const WeightFile> file)
+    : file_(std::move(file)) {
+  const WeightFile::Header& header = file_->GetHeader();
+  if (WeightFile::DtypeSize(header.dtype) != sizeof(T) ||
+      __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__) {
+    throw std::runtime_error("формат весов не подходит для отображения");
+  }
+
+  const NetworkSettings settings = file_->GetSettings();
+  const T* weights = static_cast<const T*>(file_->Payload());
+  std::size_t columns = settings.neurons_in_input_layer;
+  for (std::size_t i = 0; i <= settings.number_of_hidden_layers; i++) {
+    const std::size_t rows = i < settings.number_of_hidden_layers
+                                 ? settings.neurons_in_hidden_layer
+                                 : settings.neurons_in_output_layer;
+    layers_.push_back({weights, rows, columns});
+    weights += rows * columns;
+    columns = rows;
+  }
+  Reserve(&single_, 1);
+  Reserve(&infer_, 1);
+}
+
+template <typename T>
+void MappedNetwork<T>::Reserve(State *state, std::size_t batch) const {
+  if (batch <= state->capacity) return;
+  state->values.resize(layers_.size() + 1);
+  state->values[0].resize(batch * layers_.front().columns);
+  for (std::size_t i = 0; i < layers_.size(); i++) {
+    state->values[i + 1].resize(batch * layers_[i].rows);
+  }
+  state->capacity = batch;
+}
+
+// A single sample goes through GEMV, a batch through GEMM against W^T.
+template <typename T>
+void MappedNetwork<T>::Forward(State *state, std::size_t batch) const {
+  for (std::size_t i = 0; i < layers_.size(); i++) {
+    const LayerView &layer = layers_[i];
+    const T *in = state->values[i].data();
+    T *out = state->values[i + 1].data();
+    if (batch == 1) {
+      kernels::Gemv(layer.rows, layer.columns, layer.weights, layer.columns,
+                    in, out);
+    } else {
+      kernels::Gemm(kernels::Transpose::kNo, kernels::Transpose::kYes, batch,
+                    layer.rows, layer.columns, 1, in, layer.columns,
+                    layer.weights, layer.columns, 0, out, layer.rows);
+    }
+    kernels::Sigmoid(batch * layer.rows, out, out);
+  }
+}
+
+template <typename T>
+void MappedNetwork<T>::SetInput(const std::vector<double> &outputs) {
+  std::vector<T> &input = single_.values.front();
+  std::copy_n(outputs.begin(), std::min(outputs.size(), input.size()),
+              input.begin());
+}
+
+template <typename T>
+void MappedNetwork<T>::SetScaledInput(const std::uint8_t *input,
+                                      double scale) {
+  std::vector<T> &values = single_.values.front();
+  kernels::ScaleBytes(values.size(), static_cast<T>(scale), input,
+                      values.data());
+}
+
+template <typename T>
+void MappedNetwork<T>::ForwardPropagation() {
+  Forward(&single_, 1);
+}
+
+template <typename T>
+void MappedNetwork<T>::BackPropagation(const std::vector<double> &,
+                                       double) {
+  throw std::runtime_error("сеть загружена только для распознавания");
+}
+
+template <typename T>
+std::vector<double> MappedNetwork<T>::GetOutput() {
+  const std::vector<T> &output = single_.values.back();
+  return std::vector<double>(output.begin(), output.end());
+}
+
+template <typename T>
+void MappedNetwork<T>::CopyOutput(double *output) const {
+  const std::vector<T> &values = single_.values.back();
+  std::copy(values.begin(), values.end(), output);
+}
+
+template <typename T>
+std::size_t MappedNetwork<T>::PrepareInference(std::size_t workers,
+                                               std::size_t batch) {
+  workers = std::max<std::size_t>(workers, 1);
+  if (inference_.size() < workers) inference_.resize(workers);
+  for (std::size_t i = 0; i < workers; i++) Reserve(&inference_[i], batch);
+  return workers;
+}
+
+// Workers only read the mapping, so any number of them can run at once.
+template <typename T>
+void MappedNetwork<T>::PredictBatch(std::size_t worker,
+                                    const std::uint8_t *const *inputs,
+                                    std::size_t count, double scale,
+                                    double *outputs) {
+  State *state = &inference_[worker];
+  Reserve(state, count);
+  const std::size_t input_size = layers_.front().columns;
+  T *values = state->values.front().data();
+  for (std::size_t b = 0; b < count; b++) {
+    kernels::ScaleBytes(input_size, static_cast<T>(scale), inputs[b],
+                        values + b * input_size);
+  }
+  Forward(state, count);
+  std::copy_n(state->values.back().begin(), count * layers_.back().rows,
+              outputs);
+}
+
+template <typename T>
+void MappedNetwork<T>::Infer(const std::uint8_t *input, double scale,
+                             double *output) {
+  std::vector<T> &values = infer_.values.front();
+  kernels::ScaleBytes(values.size(), static_cast<T>(scale), input,
+                      values.data());
+  Forward(&infer_, 1);
+  std::copy(infer_.values.back().begin(), infer_.values.back().end(), output);
+}
+
+template <typename T>
+std::vector<double> MappedNetwork<T>::GetWeights() {
+  return file_->ToDoubles();
+}
+
+template <typename T>
+void MappedNetwork<T>::LoadWeights(const std::vector<double> &) {
+  throw std::runtime_error("сеть загружена только для распознавания");
+}
+
+template class MappedNetwork<double>;
+template class MappedNetwork<float>;
+
+}  // namespace s21
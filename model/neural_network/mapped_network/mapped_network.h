@@ -0,0 +1,80 @@
+#ifndef SRC_MODEL_NEURAL_NETWORK_MAPPED_NETWORK_MAPPED_NETWORK_H_
+#define SRC_MODEL_NEURAL_NETWORK_MAPPED_NETWORK_MAPPED_NETWORK_H_
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "../../../lib/matrixplus/s21_gemm.h"
+#include "../../../lib/matrixplus/s21_kernels.h"
+#include "../io/weight_file.h"
+#include "../network_interface.h"
+
+namespace s21 {
+
+// Inference-only perceptron whose weight matrices are views into the payload
+// of a mapped version 2 weight file, so loading copies nothing and startup
+// costs only the page faults of the first pass. The mapping is read-only and
+// backed by the page cache, so processes that map the same file share its
+// physical pages. T must match the dtype of the file.
+//
+// The file must not be rewritten in place while it is mapped; writers
+// replace it instead. Training calls throw std::runtime_error.
+template <typename T>
+class MappedNetwork : public NetworkInterface {
+ public:
+  explicit MappedNetwork(std::shared_ptr<const WeightFile> file);
+  ~MappedNetwork() = default;
+
+  void SetInput(const std::vector<double>& outputs) override;
+  void SetScaledInput(const std::uint8_t* input, double scale) override;
+  void ForwardPropagation() override;
+  void BackPropagation(const std::vector<double>& expected_output,
+                       double learning_rate_) override;
+  std::vector<double> GetOutput() override;
+  void CopyOutput(double* output) const override;
+
+  std::size_t PrepareInference(std::size_t workers,
+                               std::size_t batch) override;
+  void PredictBatch(std::size_t worker, const std::uint8_t* const* inputs,
+                    std::size_t count, double scale,
+                    double* outputs) override;
+  void Infer(const std::uint8_t* input, double scale,
+             double* output) override;
+
+  std::vector<double> GetWeights() override;
+  void LoadWeights(const std::vector<double>& weights) override;
+
+ private:
+  // Row-major rows x columns block of the payload.
+  struct LayerView {
+    const T* weights;
+    std::size_t rows;
+    std::size_t columns;
+  };
+  // Activations of up to |capacity| samples, one sample per row.
+  struct State {
+    std::vector<std::vector<T>> values;
+    std::size_t capacity = 0;
+  };
+
+  void Reserve(State* state, std::size_t batch) const;
+  void Forward(State* state, std::size_t batch) const;
+
+  std::shared_ptr<const WeightFile> file_;
+  std::vector<LayerView> layers_;
+  // State of SetInput/ForwardPropagation/GetOutput.
+  State single_;
+  // One state per inference worker.
+  std::vector<State> inference_;
+  // State of Infer.
+  State infer_;
+};
+
+extern template class MappedNetwork<double>;
+extern template class MappedNetwork<float>;
+
+}  // namespace s21
+
+#endif  // SRC_MODEL_NEURAL_NETWORK_MAPPED_NETWORK_MAPPED_NETWORK_H_
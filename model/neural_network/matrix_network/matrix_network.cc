@@ -2,8 +2,8 @@
 
 namespace s21 {
 
-MatrixNetwork::MatrixNetwork(NetworkSettings settings)
-    : values_(settings.number_of_hidden_layers + 2) {
+template <typename T>
+BasicMatrixNetwork<T>::BasicMatrixNetwork(NetworkSettings settings) {
   Matrix weight(settings.neurons_in_hidden_layer,
                 settings.neurons_in_input_layer);
 
@@ -21,107 +21,395 @@ MatrixNetwork::MatrixNetwork(NetworkSettings settings)
                   settings.neurons_in_hidden_layer);
   FillMatrixRandom(weight);
   weights_.push_back(weight);
+
+  samples_.push_back(MakeSampleState());
+  infer_ = MakeSampleState();
+}
+
+template <typename T>
+typename BasicMatrixNetwork<T>::SampleState
+BasicMatrixNetwork<T>::MakeSampleState() const {
+  SampleState state;
+  state.values.emplace_back(weights_.front().GetColumns(), 1);
+  for (const Matrix &w : weights_) {
+    state.values.emplace_back(w.GetRows(), 1);
+    state.errors.emplace_back(w.GetRows(), 1);
+  }
+  return state;
+}
+
+template <typename T>
+void BasicMatrixNetwork<T>::SetInput(const std::vector<double> &outputs) {
+  Matrix &input = samples_.front().values.front();
+  if (input.GetSize() != outputs.size()) input = Matrix(outputs.size(), 1);
+  std::copy(outputs.begin(), outputs.end(), input.Data());
+}
+
+template <typename T>
+void BasicMatrixNetwork<T>::SetScaledInput(const std::uint8_t *input,
+                                           double scale) {
+  Matrix &values = samples_.front().values.front();
+  kernels::ScaleBytes(values.GetSize(), static_cast<T>(scale), input,
+                      values.Data());
+}
+
+template <typename T>
+void BasicMatrixNetwork<T>::ForwardPropagation() {
+  ForwardPropagation(&samples_.front());
 }
 
-void MatrixNetwork::SetInput(const std::vector<double> &outputs) {
-  values_.front() = Matrix(outputs);
+template <typename T>
+void BasicMatrixNetwork<T>::BackPropagation(
+    const std::vector<double> &expected_output, double learning_rate_) {
+  BackPropagation(&samples_.front(), expected_output, learning_rate_);
 }
 
-void MatrixNetwork::ForwardPropagation() {
+template <typename T>
+void BasicMatrixNetwork<T>::ForwardPropagation(SampleState *state) {
+  std::vector<Matrix> &values = state->values;
   for (size_t i = 0; i < weights_.size(); i++) {
-    values_[i + 1] = ActivationFuncMatrix(weights_[i] * values_[i]);
+    weights_[i].Gemv(values[i], &values[i + 1]);
+    ActivationFuncMatrix(&values[i + 1]);
   }
 }
 
-Matrix Mul(const Matrix &m1, const Matrix &m2) {
-  if (m1.GetColumns() != m2.GetColumns() || m2.GetRows() != m1.GetRows())
-    throw std::logic_error("Mul: invalid matrix dims");
+template <typename T>
+void BasicMatrixNetwork<T>::BackPropagation(
+    SampleState *state, const std::vector<double> &expected_output,
+    double learning_rate) {
+  std::vector<Matrix> &values = state->values;
+  std::vector<Matrix> &errors = state->errors;
+  const Matrix &output = values.back();
+  Matrix &error = errors.back();
+  for (size_t i = 0; i < output.GetSize(); i++) {
+    error.Data()[i] = static_cast<T>(output.Data()[i] - expected_output[i]);
+  }
+  MulDerivativeActivationFunc(output, &error);
+  AdjustWeights(weights_.size() - 1, learning_rate, error,
+                values[weights_.size() - 1]);
 
-  Matrix res(m1.GetRows(), m1.GetColumns());
-  for (size_t i = 0; i < m1.GetRows(); i++)
-    for (size_t j = 0; j < m1.GetColumns(); j++) {
-      res(i, j) = m1(i, j) * m2(i, j);
+  for (int i = (int)weights_.size() - 2; i >= 0; i--) {
+    weights_[i + 1].GemvTransposed(errors[i + 1], &errors[i]);
+    MulDerivativeActivationFunc(values[i + 1], &errors[i]);
+    AdjustWeights(i, learning_rate, errors[i], values[i]);
+  }
+}
+
+template <typename T>
+void BasicMatrixNetwork<T>::AdjustWeights(size_t weight_ind,
+                                          double learning_rate,
+                                          const Matrix &error,
+                                          const Matrix &values) {
+  weights_[weight_ind].Ger(static_cast<T>(-learning_rate), error, values);
+}
+
+template <typename T>
+std::size_t BasicMatrixNetwork<T>::PrepareWorkers(std::size_t workers) {
+  while (samples_.size() < workers) samples_.push_back(MakeSampleState());
+  return std::max<std::size_t>(workers, 1);
+}
+
+// Hogwild step: plain per-sample SGD on the worker's own activations. Other
+// workers read and update weights_ at the same time without any locking;
+// with sparse gradients the overlapping writes are rare and a lost update
+// only costs a little progress.
+template <typename T>
+void BasicMatrixNetwork<T>::TrainSample(
+    std::size_t worker, const std::vector<double> &input,
+    const std::vector<double> &expected_output, double learning_rate) {
+  SampleState *state = &samples_[worker];
+  std::copy_n(input.begin(), state->values.front().GetSize(),
+              state->values.front().Data());
+  ForwardPropagation(state);
+  BackPropagation(state, expected_output, learning_rate);
+}
+
+template <typename T>
+void BasicMatrixNetwork<T>::TrainBatch(
+    const std::vector<const std::vector<double> *> &inputs,
+    const std::vector<const std::vector<double> *> &expected_outputs,
+    double learning_rate) {
+  if (inputs.empty()) return;
+  if (pool_) {
+    TrainBatchParallel(inputs, expected_outputs, learning_rate);
+    return;
+  }
+
+  const std::size_t batch = inputs.size();
+  ReserveBatch(&batch_, batch, false);
+  LoadBatch(&batch_, inputs, 0, batch);
+  ForwardPropagationBatch(&batch_, batch);
+  OutputErrorBatch(&batch_, expected_outputs, 0, batch);
+  BackPropagationBatch(&batch_, batch, learning_rate);
+}
+
+template <typename T>
+void BasicMatrixNetwork<T>::SetThreads(std::size_t threads) {
+  threads = std::max<std::size_t>(threads, 1);
+  if (threads == (pool_ ? pool_->GetThreads() : 1)) return;
+
+  pool_.reset();
+  replicas_.clear();
+  if (threads > 1) {
+    pool_ = std::make_unique<ThreadPool>(threads);
+    replicas_.resize(threads);
+  }
+}
+
+// Every thread runs forward and backward passes over its own contiguous shard
+// of the batch against the same weights and leaves the shard gradient in its
+// replica. The gradients are then summed pairwise in a fixed tree order, so
+// for a given thread count the result does not depend on scheduling.
+template <typename T>
+void BasicMatrixNetwork<T>::TrainBatchParallel(
+    const std::vector<const std::vector<double> *> &inputs,
+    const std::vector<const std::vector<double> *> &expected_outputs,
+    double learning_rate) {
+  const std::size_t batch = inputs.size();
+  const std::size_t threads = pool_->GetThreads();
+
+  pool_->Run([&](std::size_t t) {
+    const std::size_t first = batch * t / threads;
+    const std::size_t size = batch * (t + 1) / threads - first;
+    BatchState *state = &replicas_[t];
+    ReserveBatch(state, std::max<std::size_t>(size, 1), true);
+    LoadBatch(state, inputs, first, size);
+    ForwardPropagationBatch(state, size);
+    OutputErrorBatch(state, expected_outputs, first, size);
+    ComputeGradients(state, size);
+  });
+
+  for (std::size_t stride = 1; stride < threads; stride *= 2) {
+    pool_->Run([&](std::size_t t) {
+      if (t % (2 * stride) != 0 || t + stride >= threads) return;
+      std::vector<Matrix> &sum = replicas_[t].gradients;
+      const std::vector<Matrix> &other = replicas_[t + stride].gradients;
+      for (std::size_t i = 0; i < sum.size(); i++) {
+        kernels::Axpy(sum[i].GetSize(), 1, other[i].Data(), sum[i].Data());
+      }
+    });
+  }
+
+  // The update is split by rows of each weight matrix.
+  const T step = static_cast<T>(-learning_rate / static_cast<double>(batch));
+  pool_->Run([&](std::size_t t) {
+    for (std::size_t i = 0; i < weights_.size(); i++) {
+      Matrix &w = weights_[i];
+      const std::size_t first = w.GetRows() * t / threads * w.GetStride();
+      const std::size_t last = w.GetRows() * (t + 1) / threads * w.GetStride();
+      const T *gradient = replicas_[0].gradients[i].Data();
+      kernels::Axpy(last - first, step, gradient + first, w.Data() + first);
     }
-  return res;
+  });
 }
 
-void MatrixNetwork::BackPropagation(const std::vector<double> &expected_output,
-                                    double learning_rate_) {
-  Matrix error = values_.back() - Matrix(expected_output);
-  error = Mul(error, DerivativeActivationFuncMatrix(values_.back()));
-  AdjustWeights(weights_.size() - 1, learning_rate_, error);
+template <typename T>
+std::size_t BasicMatrixNetwork<T>::PrepareInference(std::size_t workers,
+                                                    std::size_t batch) {
+  workers = std::max<std::size_t>(workers, 1);
+  if (inference_.size() < workers) inference_.resize(workers);
+  for (std::size_t i = 0; i < workers; i++) {
+    ReserveBatch(&inference_[i], batch, false);
+  }
+  return workers;
+}
 
-  for (int i = (int)weights_.size() - 2; i >= 0; i--) {
-    error = Mul(weights_[i + 1].Transpose() * error,
-                DerivativeActivationFuncMatrix(values_[i + 1]));
-    AdjustWeights(i, learning_rate_, error);
+// Workers only read weights_, so any number of them can run at once.
+template <typename T>
+void BasicMatrixNetwork<T>::PredictBatch(std::size_t worker,
+                                         const std::uint8_t *const *inputs,
+                                         std::size_t count, double scale,
+                                         double *outputs) {
+  BatchState *state = &inference_[worker];
+  ReserveBatch(state, count, false);
+  const std::size_t input_size = weights_.front().GetColumns();
+  T *values = state->values.front().Data();
+  for (std::size_t b = 0; b < count; b++) {
+    kernels::ScaleBytes(input_size, static_cast<T>(scale), inputs[b],
+                        values + b * input_size);
   }
+  ForwardPropagationBatch(state, count);
+  std::copy_n(state->values.back().Data(), count * weights_.back().GetRows(),
+              outputs);
 }
 
-void MatrixNetwork::AdjustWeights(size_t weight_ind, double learning_rate,
-                                  const Matrix &error) {
-  weights_[weight_ind] -=
-      learning_rate * error * values_[weight_ind].Transpose();
+template <typename T>
+void BasicMatrixNetwork<T>::Infer(const std::uint8_t *input, double scale,
+                                  double *output) {
+  Matrix &values = infer_.values.front();
+  kernels::ScaleBytes(values.GetSize(), static_cast<T>(scale), input,
+                      values.Data());
+  ForwardPropagation(&infer_);
+  const Matrix &result = infer_.values.back();
+  std::copy_n(result.Data(), result.GetSize(), output);
 }
 
-std::vector<double> MatrixNetwork::GetOutput() {
-  std::vector<double> result(values_.back().GetRows(), 0);
+template <typename T>
+void BasicMatrixNetwork<T>::ReserveBatch(BatchState *state, std::size_t batch,
+                                         bool gradients) const {
+  if (batch <= state->capacity) return;
 
-  for (size_t i = 0; i < values_.back().GetRows(); i++) {
-    result[i] = values_.back()(i, 0);
+  state->values.clear();
+  state->errors.clear();
+  state->values.emplace_back(batch, weights_.front().GetColumns());
+  for (const Matrix &w : weights_) {
+    state->values.emplace_back(batch, w.GetRows());
+    state->errors.emplace_back(batch, w.GetRows());
+    if (gradients && state->gradients.size() < weights_.size()) {
+      state->gradients.emplace_back(w.GetRows(), w.GetColumns());
+    }
   }
+  state->capacity = batch;
+}
 
-  return result;
+template <typename T>
+void BasicMatrixNetwork<T>::LoadBatch(
+    BatchState *state, const std::vector<const std::vector<double> *> &inputs,
+    std::size_t first, std::size_t batch) const {
+  const std::size_t input_size = weights_.front().GetColumns();
+  for (std::size_t b = 0; b < batch; b++) {
+    std::copy_n(inputs[first + b]->begin(), input_size,
+                state->values.front().Data() + b * input_size);
+  }
 }
 
-std::vector<double> MatrixNetwork::GetWeights() {
-  std::vector<double> weights;
+// Z = X * W^T for the batch X, one sample per row.
+template <typename T>
+void BasicMatrixNetwork<T>::ForwardPropagationBatch(BatchState *state,
+                                                    std::size_t batch) const {
+  for (size_t i = 0; i < weights_.size(); i++) {
+    const Matrix &w = weights_[i];
+    T *out = state->values[i + 1].Data();
+    kernels::Gemm(kernels::Transpose::kNo, kernels::Transpose::kYes, batch,
+                  w.GetRows(), w.GetColumns(), 1, state->values[i].Data(),
+                  w.GetColumns(), w.Data(), w.GetColumns(), 0, out,
+                  w.GetRows());
+    kernels::Sigmoid(batch * w.GetRows(), out, out);
+  }
+}
 
-  for (auto &matrix : weights_) {
-    for (std::size_t row = 0; row < matrix.GetRows(); row++) {
-      for (std::size_t column = 0; column < matrix.GetColumns(); column++) {
-        weights.push_back(matrix(row, column));
-      }
+template <typename T>
+void BasicMatrixNetwork<T>::OutputErrorBatch(
+    BatchState *state,
+    const std::vector<const std::vector<double> *> &expected_outputs,
+    std::size_t first, std::size_t batch) const {
+  const std::size_t outputs = weights_.back().GetRows();
+  const T *output = state->values.back().Data();
+  T *error = state->errors.back().Data();
+  for (std::size_t b = 0; b < batch; b++) {
+    for (std::size_t j = 0; j < outputs; j++) {
+      error[b * outputs + j] = static_cast<T>(
+          output[b * outputs + j] - (*expected_outputs[first + b])[j]);
     }
   }
+  kernels::MulSigmoidDerivative(batch * outputs, output, error);
+}
+
+// E[i - 1] = (E[i] * W[i]) .* f'(Y[i]), one sample per row.
+template <typename T>
+void BasicMatrixNetwork<T>::PropagateErrorBatch(BatchState *state,
+                                                std::size_t batch,
+                                                std::size_t i) const {
+  const Matrix &w = weights_[i];
+  kernels::Gemm(kernels::Transpose::kNo, kernels::Transpose::kNo, batch,
+                w.GetColumns(), w.GetRows(), 1, state->errors[i].Data(),
+                w.GetRows(), w.Data(), w.GetColumns(), 0,
+                state->errors[i - 1].Data(), w.GetColumns());
+  kernels::MulSigmoidDerivative(batch * w.GetColumns(),
+                                state->values[i].Data(),
+                                state->errors[i - 1].Data());
+}
 
+// Errors are propagated through each weight matrix before it is updated, so
+// the whole batch sees the same weights.
+template <typename T>
+void BasicMatrixNetwork<T>::BackPropagationBatch(BatchState *state,
+                                                 std::size_t batch,
+                                                 double learning_rate) {
+  const T step = static_cast<T>(-learning_rate / static_cast<double>(batch));
+  for (std::size_t i = weights_.size(); i-- > 0;) {
+    Matrix &w = weights_[i];
+    if (i > 0) PropagateErrorBatch(state, batch, i);
+    kernels::Gemm(kernels::Transpose::kYes, kernels::Transpose::kNo,
+                  w.GetRows(), w.GetColumns(), batch, step,
+                  state->errors[i].Data(), w.GetRows(),
+                  state->values[i].Data(), w.GetColumns(), 1, w.Data(),
+                  w.GetColumns());
+  }
+}
+
+// Same passes as BackPropagationBatch, but the unscaled gradient E^T * X of
+// every layer is stored in the state instead of being applied.
+template <typename T>
+void BasicMatrixNetwork<T>::ComputeGradients(BatchState *state,
+                                             std::size_t batch) const {
+  for (std::size_t i = weights_.size(); i-- > 0;) {
+    const Matrix &w = weights_[i];
+    if (i > 0) PropagateErrorBatch(state, batch, i);
+    kernels::Gemm(kernels::Transpose::kYes, kernels::Transpose::kNo,
+                  w.GetRows(), w.GetColumns(), batch, 1,
+                  state->errors[i].Data(), w.GetRows(),
+                  state->values[i].Data(), w.GetColumns(), 0,
+                  state->gradients[i].Data(), w.GetColumns());
+  }
+}
+
+template <typename T>
+std::vector<double> BasicMatrixNetwork<T>::GetOutput() {
+  const Matrix &output = samples_.front().values.back();
+  return std::vector<double>(output.Data(), output.Data() + output.GetSize());
+}
+
+template <typename T>
+void BasicMatrixNetwork<T>::CopyOutput(double *output) const {
+  const Matrix &values = samples_.front().values.back();
+  std::copy_n(values.Data(), values.GetSize(), output);
+}
+
+template <typename T>
+std::vector<double> BasicMatrixNetwork<T>::GetWeights() {
+  std::vector<double> weights;
+  CopyWeights(&weights);
   return weights;
 }
 
-void MatrixNetwork::LoadWeights(const std::vector<double> &weights) {
+template <typename T>
+void BasicMatrixNetwork<T>::CopyWeights(std::vector<double> *weights) {
+  weights->clear();
+  for (auto &matrix : weights_) {
+    weights->insert(weights->end(), matrix.Data(),
+                    matrix.Data() + matrix.GetSize());
+  }
+}
+
+template <typename T>
+void BasicMatrixNetwork<T>::LoadWeights(const std::vector<double> &weights) {
   std::size_t i = 0;
   for (auto &matrix : weights_) {
-    for (std::size_t row = 0; row < matrix.GetRows(); row++) {
-      for (std::size_t column = 0; column < matrix.GetColumns(); column++) {
-        matrix(row, column) = weights[i++];
-      }
-    }
+    std::copy_n(weights.begin() + static_cast<std::ptrdiff_t>(i),
+                matrix.GetSize(), matrix.Data());
+    i += matrix.GetSize();
   }
 }
 
-void MatrixNetwork::FillMatrixRandom(Matrix &m) {
-  for (size_t i = 0; i < m.GetRows(); i++)
-    for (size_t j = 0; j < m.GetColumns(); j++) {
-      m(i, j) = utility::RandomWeight();
-    }
+template <typename T>
+void BasicMatrixNetwork<T>::FillMatrixRandom(Matrix &m) {
+  utility::FillRandom(m.Data(), m.GetSize());
 }
 
-Matrix MatrixNetwork::ActivationFuncMatrix(const Matrix &m) {
-  Matrix res(m.GetRows(), m.GetColumns());
-  for (size_t i = 0; i < m.GetRows(); i++)
-    for (size_t j = 0; j < m.GetColumns(); j++) {
-      res(i, j) = utility::ActivationFunc(m(i, j));
-    }
-  return res;
+template <typename T>
+void BasicMatrixNetwork<T>::ActivationFuncMatrix(Matrix *m) {
+  kernels::Sigmoid(m->GetSize(), m->Data(), m->Data());
 }
 
-Matrix MatrixNetwork::DerivativeActivationFuncMatrix(const Matrix &m) {
-  Matrix res(m.GetRows(), m.GetColumns());
-  for (size_t i = 0; i < m.GetRows(); i++)
-    for (size_t j = 0; j < m.GetColumns(); j++) {
-      res(i, j) = utility::DerivativeActivFunc(m(i, j));
-    }
-  return res;
+template <typename T>
+void BasicMatrixNetwork<T>::MulDerivativeActivationFunc(const Matrix &values,
+                                                        Matrix *error) {
+  kernels::MulSigmoidDerivative(values.GetSize(), values.Data(),
+                                error->Data());
 }
 
+template class BasicMatrixNetwork<double>;
+template class BasicMatrixNetwork<float>;
+
 }  // namespace s21
@@ -1,36 +1,127 @@
 #ifndef SRC_MODEL_NEURAL_NETWORK_MATRIX_NETWORK_MATRIX_NETWORK_H_
 #define SRC_MODEL_NEURAL_NETWORK_MATRIX_NETWORK_MATRIX_NETWORK_H_
 
+#include <memory>
+
 #include "../../../lib/matrixplus/s21_matrix_oop.h"
+#include "../../thread_pool.h"
 #include "../network_interface.h"
 #include "../utility.h"
 
 namespace s21 {
 
-class MatrixNetwork : public NetworkInterface {
+// Layers as dense weight matrices. T is the precision of the weights and of
+// all the math; the interface stays double and converts at the boundary.
+template <typename T>
+class BasicMatrixNetwork : public NetworkInterface {
  public:
-  explicit MatrixNetwork(NetworkSettings settings);
-  ~MatrixNetwork() = default;
+  explicit BasicMatrixNetwork(NetworkSettings settings);
+  ~BasicMatrixNetwork() = default;
 
   void SetInput(const std::vector<double>& outputs) override;
+  void SetScaledInput(const std::uint8_t* input, double scale) override;
   void ForwardPropagation() override;
   void BackPropagation(const std::vector<double>& expected_output,
                        double learning_rate_) override;
   std::vector<double> GetOutput() override;
+  void CopyOutput(double* output) const override;
+
+  void TrainBatch(
+      const std::vector<const std::vector<double>*>& inputs,
+      const std::vector<const std::vector<double>*>& expected_outputs,
+      double learning_rate) override;
+  void SetThreads(std::size_t threads) override;
+
+  std::size_t PrepareWorkers(std::size_t workers) override;
+  void TrainSample(std::size_t worker, const std::vector<double>& input,
+                   const std::vector<double>& expected_output,
+                   double learning_rate) override;
+
+  std::size_t PrepareInference(std::size_t workers,
+                               std::size_t batch) override;
+  void PredictBatch(std::size_t worker, const std::uint8_t* const* inputs,
+                    std::size_t count, double scale,
+                    double* outputs) override;
+  void Infer(const std::uint8_t* input, double scale,
+             double* output) override;
 
   std::vector<double> GetWeights() override;
+  void CopyWeights(std::vector<double>* weights) override;
   void LoadWeights(const std::vector<double>& weights) override;
 
  private:
+  using Matrix = BasicMatrix<T>;
+
+  // Activations and errors of a single sample.
+  struct SampleState {
+    std::vector<Matrix> values;
+    std::vector<Matrix> errors;
+  };
+
+  SampleState MakeSampleState() const;
+  void ForwardPropagation(SampleState* state);
+  void BackPropagation(SampleState* state,
+                       const std::vector<double>& expected_output,
+                       double learning_rate);
+
   void FillMatrixRandom(Matrix& m);
-  Matrix ActivationFuncMatrix(const Matrix& m);
-  Matrix DerivativeActivationFuncMatrix(const Matrix& m);
-  void AdjustWeights(size_t i, double learning_rate, const Matrix& error);
+  void ActivationFuncMatrix(Matrix* m);
+  void MulDerivativeActivationFunc(const Matrix& values, Matrix* error);
+  void AdjustWeights(size_t i, double learning_rate, const Matrix& error,
+                     const Matrix& values);
+
+  // Activations, errors and, for the data-parallel path, weight gradients of
+  // one shard of a mini-batch. Samples are rows, so a shard is a contiguous
+  // block and a short last batch just uses fewer rows.
+  struct BatchState {
+    std::vector<Matrix> values;
+    std::vector<Matrix> errors;
+    std::vector<Matrix> gradients;
+    std::size_t capacity = 0;
+  };
+
+  // Sizes |state| for |batch| samples, with weight gradients if |gradients|.
+  void ReserveBatch(BatchState* state, std::size_t batch,
+                    bool gradients) const;
+  void LoadBatch(BatchState* state,
+                 const std::vector<const std::vector<double>*>& inputs,
+                 std::size_t first, std::size_t batch) const;
+  void ForwardPropagationBatch(BatchState* state, std::size_t batch) const;
+  void OutputErrorBatch(
+      BatchState* state,
+      const std::vector<const std::vector<double>*>& expected_outputs,
+      std::size_t first, std::size_t batch) const;
+  void PropagateErrorBatch(BatchState* state, std::size_t batch,
+                           std::size_t i) const;
+  void BackPropagationBatch(BatchState* state, std::size_t batch,
+                            double learning_rate);
+  void ComputeGradients(BatchState* state, std::size_t batch) const;
+  void TrainBatchParallel(
+      const std::vector<const std::vector<double>*>& inputs,
+      const std::vector<const std::vector<double>*>& expected_outputs,
+      double learning_rate);
 
-  std::vector<Matrix> values_;
   std::vector<Matrix> weights_;
+  // State of the single-sample passes. Entry 0 backs SetInput/GetOutput, the
+  // others belong to Hogwild workers, which share weights_ without locking.
+  std::vector<SampleState> samples_;
+
+  BatchState batch_;
+  // One replica per pool thread; replica 0 ends up holding the reduced
+  // gradient.
+  std::vector<BatchState> replicas_;
+  std::unique_ptr<ThreadPool> pool_;
+  // One forward-only state per inference worker.
+  std::vector<BatchState> inference_;
+  // State of Infer.
+  SampleState infer_;
 };
 
+using MatrixNetwork = BasicMatrixNetwork<double>;
+
+extern template class BasicMatrixNetwork<double>;
+extern template class BasicMatrixNetwork<float>;
+
 }  // namespace s21
 
 #endif  // SRC_MODEL_NEURAL_NETWORK_MATRIX_NETWORK_MATRIX_NETWORK_H_
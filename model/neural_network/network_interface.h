@@ -1,19 +1,51 @@
 #ifndef SRC_MODEL_NEURAL_NETWORK_NETWORK_INTERFACE_H_
 #define SRC_MODEL_NEURAL_NETWORK_NETWORK_INTERFACE_H_
 
+#include <cstdint>
 #include <vector>
 
 namespace s21 {
 
 enum class NetworkType { kMatrix, kGraph };
 
+// Precision of the weights and of all network math. kFloat halves the memory
+// traffic of every pass; inputs, outputs and weight files stay double.
+enum class Precision { kDouble, kFloat };
+
+// kSynchronous trains in (possibly sharded) mini-batches with one update per
+// batch. kHogwild runs one plain SGD loop per thread over disjoint parts of
+// the data, all of them updating the shared weights without locks.
+enum class TrainMode { kSynchronous, kHogwild };
+
 struct NetworkTestMetrics {
   double accuracy = 0;
   std::size_t accuracy_percent = 0;
   double precision = 0;
   double recall = 0;
   double fscore = 0;
-  std::size_t time;
+  std::size_t time = 0;
+
+  // The prediction of a sample is its strongest output. confusion holds
+  // classes x classes counts, row = true class, column = predicted one.
+  std::size_t classes = 0;
+  std::vector<std::size_t> confusion;
+  // Per class, from the confusion matrix; 0 where a class was never
+  // predicted or never seen.
+  std::vector<double> class_precision;
+  std::vector<double> class_recall;
+  std::vector<double> class_fscore;
+  // top_k_accuracy[k - 1] is the share of samples whose class is among the k
+  // strongest outputs.
+  std::vector<double> top_k_accuracy;
+};
+
+// Result of k-fold cross-validation: the metrics of every fold, their mean
+// and standard deviation, and the fold whose network was kept.
+struct CrossValidationMetrics {
+  std::vector<NetworkTestMetrics> folds;
+  NetworkTestMetrics mean;
+  NetworkTestMetrics stddev;
+  std::size_t best_fold = 0;
 };
 
 struct NetworkSettings {
@@ -28,11 +60,80 @@ class NetworkInterface {
   virtual ~NetworkInterface() = default;
 
   virtual void SetInput(const std::vector<double>& outputs) = 0;
+  // Sets input i to scale * input[i], writing straight into the input layer.
+  // |input| must hold neurons_in_input_layer values.
+  virtual void SetScaledInput(const std::uint8_t* input, double scale) = 0;
   virtual void BackPropagation(const std::vector<double>& expected_output,
                                double learning_rate_) = 0;
   virtual void ForwardPropagation() = 0;
   virtual std::vector<double> GetOutput() = 0;
+  // Writes the output layer to |output|, which must hold
+  // neurons_in_output_layer values. Does not allocate.
+  virtual void CopyOutput(double* output) const = 0;
+
+  // Trains on a mini-batch: one forward and backward pass over all samples and
+  // a single update with the averaged gradient. Backends without a batched
+  // path fall back to per-sample updates.
+  virtual void TrainBatch(
+      const std::vector<const std::vector<double>*>& inputs,
+      const std::vector<const std::vector<double>*>& expected_outputs,
+      double learning_rate) {
+    for (std::size_t i = 0; i < inputs.size(); i++) {
+      SetInput(*inputs[i]);
+      ForwardPropagation();
+      BackPropagation(*expected_outputs[i], learning_rate);
+    }
+  }
+
+  // Number of threads a batch is split across. Backends without a parallel
+  // path ignore it.
+  virtual void SetThreads(std::size_t /*threads*/) {}
+
+  // Prepares per-thread state for Hogwild training and returns how many
+  // workers may call TrainSample concurrently. Backends whose passes share
+  // state return 1 and are trained from a single thread.
+  virtual std::size_t PrepareWorkers(std::size_t /*workers*/) { return 1; }
+  // One SGD step on a single sample using the state of |worker|.
+  virtual void TrainSample(std::size_t /*worker*/,
+                           const std::vector<double>& input,
+                           const std::vector<double>& expected_output,
+                           double learning_rate) {
+    SetInput(input);
+    ForwardPropagation();
+    BackPropagation(expected_output, learning_rate);
+  }
+
+  // Prepares per-thread state for batched inference of up to |batch| samples
+  // and returns how many workers may call PredictBatch concurrently.
+  virtual std::size_t PrepareInference(std::size_t /*workers*/,
+                                       std::size_t /*batch*/) {
+    return 1;
+  }
+  // Forward pass over |count| inputs, each scaled like SetScaledInput, on the
+  // state of |worker|, which PrepareInference must have set up. The outputs
+  // of sample b go to row b of |outputs|, a count x neurons_in_output_layer
+  // row-major buffer.
+  virtual void PredictBatch(std::size_t worker,
+                            const std::uint8_t* const* inputs,
+                            std::size_t count, double scale,
+                            double* outputs) = 0;
+  // Forward pass of one input, scaled like SetScaledInput, into |output|.
+  // Backends that override it run on scratch state of their own, so it
+  // leaves the state of SetInput/GetOutput alone and does not allocate.
+  virtual void Infer(const std::uint8_t* input, double scale,
+                     double* output) {
+    SetScaledInput(input, scale);
+    ForwardPropagation();
+    CopyOutput(output);
+  }
+
   virtual std::vector<double> GetWeights() = 0;
+  // Replaces the contents of |weights| with GetWeights(). Backends that
+  // override it reuse the capacity of |weights|, so a snapshot taken into
+  // the same vector every epoch does not allocate.
+  virtual void CopyWeights(std::vector<double>* weights) {
+    *weights = GetWeights();
+  }
   virtual void LoadWeights(const std::vector<double>& weights) = 0;
 };
 
@@ -2,8 +2,58 @@
 
 namespace s21 {
 
+NeuralNetwork::NeuralNetwork(NetworkType type, NetworkSettings settings,
+                             Precision precision,
+                             std::unique_ptr<NetworkInterface> network)
+    : type_(type),
+      precision_(precision),
+      settings_(settings),
+      expected_outputs_(
+          settings.neurons_in_output_layer,
+          std::vector<double>(settings.neurons_in_output_layer, 0)),
+      output_(settings.neurons_in_output_layer),
+      network_(std::move(network)) {
+  for (std::size_t i = 0; i < expected_outputs_.size(); i++) {
+    expected_outputs_[i][i] = 1;
+  }
+}
+
+std::unique_ptr<NetworkInterface> NeuralNetwork::MakeNetwork(
+    NetworkType type, const NetworkSettings& settings, Precision precision) {
+  switch (type) {
+    case NetworkType::kGraph:
+      if (precision == Precision::kFloat) {
+        return std::make_unique<BasicGraphNetwork<float>>(settings);
+      }
+      return std::make_unique<GraphNetwork>(settings);
+    case NetworkType::kMatrix:
+    default:
+      if (precision == Precision::kFloat) {
+        return std::make_unique<BasicMatrixNetwork<float>>(settings);
+      }
+      return std::make_unique<MatrixNetwork>(settings);
+  }
+}
+
+std::unique_ptr<NetworkInterface> NeuralNetwork::MakeNetwork(
+    std::shared_ptr<const WeightFile> weights) {
+  if (weights->GetHeader().dtype == WeightFile::kInt8) {
+    return std::make_unique<QuantizedNetwork>(*weights);
+  }
+  if (PrecisionOf(*weights) == Precision::kFloat) {
+    return std::make_unique<MappedNetwork<float>>(std::move(weights));
+  }
+  return std::make_unique<MappedNetwork<double>>(std::move(weights));
+}
+
+Precision NeuralNetwork::PrecisionOf(const WeightFile& weights) {
+  return weights.GetHeader().dtype == WeightFile::kFloat64
+             ? Precision::kDouble
+             : Precision::kFloat;
+}
+
 void NeuralNetwork::Train(
-    const std::list<Image>& data, std::size_t epochs, double learning_rate,
+    const Dataset& data, std::size_t epochs, double learning_rate,
     std::function<void()> start_callback,
     std::function<void(std::size_t)> epoch_progress_callback,
     std::function<void(std::size_t)> epoch_end_callback,
@@ -12,7 +62,11 @@ void NeuralNetwork::Train(
     if (start_callback) start_callback();
 
     for (std::size_t epoch = 0; epoch < epochs && !exit; epoch++) {
-      TrainEpoch(data, learning_rate, epoch_progress_callback, exit);
+      if (train_mode_ == TrainMode::kHogwild) {
+        TrainEpochHogwild(data, learning_rate, epoch_progress_callback, exit);
+      } else {
+        TrainEpoch(data, learning_rate, epoch_progress_callback, exit);
+      }
       if (epoch == 2 || epoch == 3 || epoch == 4) learning_rate /= 2;
       if (epoch_end_callback) epoch_end_callback(epoch + 1);
     }
@@ -21,19 +75,39 @@ void NeuralNetwork::Train(
 }
 
 void NeuralNetwork::TrainEpoch(
-    const std::list<Image>& data, double learning_rate,
+    const Dataset& data, double learning_rate,
     std::function<void(std::size_t)> epoch_progress_callback,
     const std::atomic_bool& exit) {
   size_t count = 1;
   size_t data_size = data.size();
 
+  if (batch_storage_.size() < batch_size_) batch_storage_.resize(batch_size_);
+  batch_inputs_.clear();
+  batch_expected_outputs_.clear();
+  batch_inputs_.reserve(batch_size_);
+  batch_expected_outputs_.reserve(batch_size_);
+
   std::size_t prev_progress = std::string::npos;
-  for (const Image& image : data) {
+  for (ImageView image : data) {
     if (exit) break;
 
-    network_->SetInput(image.GetData());
-    network_->ForwardPropagation();
-    network_->BackPropagation(ExpectedOutput(image), learning_rate);
+    if (batch_size_ == 1) {
+      SetInput(image);
+      network_->ForwardPropagation();
+      network_->BackPropagation(ExpectedOutput(image.GetNumber()),
+                                learning_rate);
+    } else {
+      std::vector<double>* input = &batch_storage_[batch_inputs_.size()];
+      LoadInput(image, input);
+      batch_inputs_.push_back(input);
+      batch_expected_outputs_.push_back(&ExpectedOutput(image.GetNumber()));
+      if (batch_inputs_.size() == batch_size_ || count == data_size) {
+        network_->TrainBatch(batch_inputs_, batch_expected_outputs_,
+                             learning_rate);
+        batch_inputs_.clear();
+        batch_expected_outputs_.clear();
+      }
+    }
 
     std::size_t progress = static_cast<std::size_t>(
         static_cast<double>(count) / static_cast<double>(data_size) * 100);
@@ -45,8 +119,60 @@ void NeuralNetwork::TrainEpoch(
   }
 }
 
+// Each worker trains on its own contiguous slice of the data. Progress is
+// counted over all workers but reported only by worker 0, which runs on the
+// calling thread like the synchronous path does.
+void NeuralNetwork::TrainEpochHogwild(
+    const Dataset& data, double learning_rate,
+    std::function<void(std::size_t)> epoch_progress_callback,
+    const std::atomic_bool& exit) {
+  const std::size_t workers = network_->PrepareWorkers(threads_);
+  ThreadPool& pool = Pool(workers);
+  if (hogwild_inputs_.size() < workers) hogwild_inputs_.resize(workers);
+
+  std::atomic<std::size_t> done(0);
+  std::size_t prev_progress = std::string::npos;
+  pool.Run([&](std::size_t worker) {
+    const std::size_t first = data.size() * worker / workers;
+    const std::size_t last = data.size() * (worker + 1) / workers;
+    std::vector<double>& input = hogwild_inputs_[worker];
+    auto start = std::chrono::steady_clock::now();
+
+    for (std::size_t i = first; i < last && !exit; i++) {
+      ImageView image = data[i];
+      LoadInput(image, &input);
+      network_->TrainSample(worker, input, ExpectedOutput(image.GetNumber()),
+                            learning_rate);
+      std::size_t count = done.fetch_add(1, std::memory_order_relaxed) + 1;
+      if (worker != 0 || !epoch_progress_callback) continue;
+
+      std::size_t progress = count * 100 / data.size();
+      if (progress != prev_progress) {
+        prev_progress = progress;
+        epoch_progress_callback(progress);
+      }
+    }
+
+    std::chrono::duration<double> seconds =
+        std::chrono::steady_clock::now() - start;
+    if (throughput_callback_ && seconds.count() > 0) {
+      throughput_callback_(
+          worker, static_cast<double>(last - first) / seconds.count());
+    }
+  });
+
+  if (epoch_progress_callback && !exit && prev_progress != 100) {
+    epoch_progress_callback(100);
+  }
+}
+
+// The first |part| of the data is split into batches dealt round-robin to the
+// workers, so every worker always gets the same batches and its scratch
+// buffers settle after the first call. Every worker keeps its own counts,
+// which are summed at the end. As in the Hogwild path, progress is counted
+// over all workers and reported by worker 0, once per percent.
 NetworkTestMetrics NeuralNetwork::Test(
-    const std::list<Image>& data, double part,
+    const Dataset& data, double part,
     std::function<void()> start_callback,
     std::function<void(std::size_t)> progress_callback,
     std::function<void(NetworkTestMetrics)> end_callback,
@@ -54,47 +180,72 @@ NetworkTestMetrics NeuralNetwork::Test(
   if (start_callback) start_callback();
 
   NetworkTestMetrics metrics;
+  auto timestamp = std::chrono::high_resolution_clock::now();
 
-  size_t true_pos = 0;
-  size_t true_neg = 0;
-  size_t false_pos = 0;
-  size_t false_neg = 0;
-
-  const double kActivationThreshold = 0.5;
+  const std::size_t partition =
+      static_cast<std::size_t>(part * (double)data.size());
+  const std::size_t size =
+      std::min(data.size(), std::max<std::size_t>(partition, 1));
+  if (size != 0 && data.GetImageSize() != settings_.neurons_in_input_layer) {
+    throw std::runtime_error("размер изображения не совпадает с сетью");
+  }
+  const std::size_t batches = (size + kTestBatchSize - 1) / kTestBatchSize;
+  const std::size_t workers =
+      network_->PrepareInference(threads_, kTestBatchSize);
+  ThreadPool& pool = Pool(workers);
+  if (test_workers_.size() < workers) test_workers_.resize(workers);
 
-  auto timestamp = std::chrono::high_resolution_clock::now();
+  std::atomic<std::size_t> done(0);
+  std::size_t prev_progress = std::string::npos;
+  pool.Run([&](std::size_t worker) {
+    TestWorker& state = test_workers_[worker];
+    ResetCounts(&state.counts);
+    state.inputs.resize(kTestBatchSize);
+    state.outputs.resize(kTestBatchSize * settings_.neurons_in_output_layer);
 
-  size_t count = 0;
-  size_t partition = (size_t)(part * (double)data.size());
-  for (const Image& image : data) {
-    if (exit) break;
+    for (std::size_t b = worker; b < batches && !exit; b += workers) {
+      const std::size_t first = b * kTestBatchSize;
+      const std::size_t count = std::min(kTestBatchSize, size - first);
+      for (std::size_t i = 0; i < count; i++) {
+        state.inputs[i] = data[first + i].Pixels();
+      }
+      network_->PredictBatch(worker, state.inputs.data(), count,
+                             1 / Image::kMaxValue, state.outputs.data());
+      for (std::size_t i = 0; i < count; i++) {
+        Count(data[first + i].GetNumber(),
+              state.outputs.data() + i * settings_.neurons_in_output_layer,
+              &state.counts);
+      }
 
-    std::pair<int, double> res = Predict(image);
-    if (res.first == image.GetNumber() - 1) {
-      if (res.second > kActivationThreshold)
-        true_pos++;
-      else
-        true_neg++;
-    } else {
-      if (res.second > kActivationThreshold)
-        false_pos++;
-      else
-        false_neg++;
+      std::size_t finished = done.fetch_add(count) + count;
+      if (worker != 0 || !progress_callback) continue;
+      std::size_t progress = finished * 100 / size;
+      if (progress != prev_progress) {
+        prev_progress = progress;
+        progress_callback(progress);
+      }
     }
-    count++;
-    if (progress_callback)
-      progress_callback(static_cast<std::size_t>(
-          static_cast<double>(count) / static_cast<double>(partition) * 100));
-    if (count > partition) break;
+  });
+  if (progress_callback && !exit && prev_progress != 100) {
+    progress_callback(100);
   }
 
-  metrics.accuracy = (double)(true_pos + true_neg) /
-                     (double)(false_pos + false_neg + true_pos + true_neg);
-  metrics.accuracy_percent = static_cast<std::size_t>(metrics.accuracy * 100);
-  metrics.precision = (double)true_pos / (double)(true_pos + false_pos);
-  metrics.recall = (double)true_pos / (double)(true_pos + false_neg);
-  metrics.fscore = 2 * (metrics.precision * metrics.recall /
-                        (metrics.precision + metrics.recall));
+  TestCounts& counts = test_counts_;
+  ResetCounts(&counts);
+  for (std::size_t i = 0; i < workers; i++) {
+    const TestCounts& part_counts = test_workers_[i].counts;
+    counts.true_pos += part_counts.true_pos;
+    counts.true_neg += part_counts.true_neg;
+    counts.false_pos += part_counts.false_pos;
+    counts.false_neg += part_counts.false_neg;
+    for (std::size_t j = 0; j < counts.confusion.size(); j++) {
+      counts.confusion[j] += part_counts.confusion[j];
+    }
+    for (std::size_t r = 0; r < kTopK; r++) {
+      counts.ranks[r] += part_counts.ranks[r];
+    }
+  }
+  FillMetrics(counts, &metrics);
 
   metrics.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
                      std::chrono::high_resolution_clock::now() - timestamp)
@@ -105,22 +256,128 @@ NetworkTestMetrics NeuralNetwork::Test(
   return metrics;
 }
 
-std::vector<double> NeuralNetwork::ExpectedOutput(const Image& image) {
-  std::vector<double> expected_output(26, 0);
-  expected_output[image.GetNumber() - 1] = 1;
-  return expected_output;
+void NeuralNetwork::ResetCounts(TestCounts* counts) const {
+  const std::size_t classes = settings_.neurons_in_output_layer;
+  counts->true_pos = counts->true_neg = 0;
+  counts->false_pos = counts->false_neg = 0;
+  counts->confusion.assign(classes * classes, 0);
+  counts->ranks.assign(kTopK, 0);
+}
+
+// A sample counts as positive when the winning output clears the activation
+// threshold, and as true when the winner is the right letter. Samples whose
+// label has no output only count as false.
+void NeuralNetwork::Count(int number, const double* output,
+                          TestCounts* counts) const {
+  const double kActivationThreshold = 0.5;
+  const std::size_t classes = settings_.neurons_in_output_layer;
+
+  const double* best = std::max_element(output, output + classes);
+  const std::size_t predicted = static_cast<std::size_t>(best - output);
+  const bool positive = *best > kActivationThreshold;
+  if (predicted + 1 == static_cast<std::size_t>(number)) {
+    (positive ? counts->true_pos : counts->true_neg)++;
+  } else {
+    (positive ? counts->false_pos : counts->false_neg)++;
+  }
+
+  if (number < 1 || static_cast<std::size_t>(number) > classes) return;
+  const std::size_t actual = static_cast<std::size_t>(number - 1);
+  counts->confusion[actual * classes + predicted]++;
+  std::size_t rank = 0;
+  for (std::size_t i = 0; i < classes; i++) rank += output[i] > output[actual];
+  if (rank < kTopK) counts->ranks[rank]++;
 }
 
-std::vector<double> NeuralNetwork::Prediction(const Image& image) {
-  network_->SetInput(image.GetData());
-  network_->ForwardPropagation();
-  return network_->GetOutput();
+void NeuralNetwork::FillMetrics(const TestCounts& counts,
+                                NetworkTestMetrics* metrics) const {
+  const std::size_t true_pos = counts.true_pos;
+  const std::size_t true_neg = counts.true_neg;
+  const std::size_t false_pos = counts.false_pos;
+  const std::size_t false_neg = counts.false_neg;
+  const std::size_t total = true_pos + true_neg + false_pos + false_neg;
+
+  metrics->accuracy = (double)(true_pos + true_neg) / (double)total;
+  metrics->accuracy_percent =
+      static_cast<std::size_t>(metrics->accuracy * 100);
+  metrics->precision = (double)true_pos / (double)(true_pos + false_pos);
+  metrics->recall = (double)true_pos / (double)(true_pos + false_neg);
+  metrics->fscore = 2 * (metrics->precision * metrics->recall /
+                         (metrics->precision + metrics->recall));
+
+  const std::size_t classes = settings_.neurons_in_output_layer;
+  metrics->classes = classes;
+  metrics->confusion = counts.confusion;
+  metrics->class_precision.assign(classes, 0);
+  metrics->class_recall.assign(classes, 0);
+  metrics->class_fscore.assign(classes, 0);
+  for (std::size_t c = 0; c < classes; c++) {
+    std::size_t predicted = 0;
+    std::size_t actual = 0;
+    for (std::size_t i = 0; i < classes; i++) {
+      predicted += counts.confusion[i * classes + c];
+      actual += counts.confusion[c * classes + i];
+    }
+    const double hits = (double)counts.confusion[c * classes + c];
+    double precision = predicted ? hits / (double)predicted : 0;
+    double recall = actual ? hits / (double)actual : 0;
+    metrics->class_precision[c] = precision;
+    metrics->class_recall[c] = recall;
+    if (precision + recall > 0) {
+      metrics->class_fscore[c] = 2 * precision * recall / (precision + recall);
+    }
+  }
+
+  metrics->top_k_accuracy.assign(kTopK, 0);
+  std::size_t within = 0;
+  for (std::size_t k = 0; k < kTopK; k++) {
+    within += counts.ranks[k];
+    metrics->top_k_accuracy[k] = (double)within / (double)total;
+  }
 }
 
-std::pair<std::size_t, double> NeuralNetwork::Predict(const Image& image) {
-  std::vector<double> output = Prediction(image);
-  auto it = std::max_element(output.begin(), output.end());
-  std::size_t max_ind = std::distance(output.begin(), it);
+ThreadPool& NeuralNetwork::Pool(std::size_t workers) {
+  if (!pool_ || pool_->GetThreads() != workers) {
+    pool_ = std::make_unique<ThreadPool>(workers);
+  }
+  return *pool_;
+}
+
+const std::vector<double>& NeuralNetwork::ExpectedOutput(int number) const {
+  return expected_outputs_.at(static_cast<std::size_t>(number - 1));
+}
+
+void NeuralNetwork::SetInput(const ImageView& image) {
+  CheckImageSize(image);
+  network_->SetScaledInput(image.Pixels(), 1 / Image::kMaxValue);
+}
+
+void NeuralNetwork::LoadInput(const ImageView& image,
+                              std::vector<double>* input) const {
+  CheckImageSize(image);
+  input->resize(image.GetSize());
+  kernels::ScaleBytes(image.GetSize(), 1 / Image::kMaxValue, image.Pixels(),
+                      input->data());
+}
+
+void NeuralNetwork::CheckImageSize(const ImageView& image) const {
+  if (image.GetSize() != settings_.neurons_in_input_layer) {
+    throw std::runtime_error("размер изображения не совпадает с сетью");
+  }
+}
+
+std::pair<std::size_t, double> NeuralNetwork::Predict(const ImageView& image) {
+  return Infer(image.Pixels(), image.GetSize());
+}
+
+std::pair<std::size_t, double> NeuralNetwork::Infer(const std::uint8_t* pixels,
+                                                    std::size_t size) {
+  if (size != settings_.neurons_in_input_layer) {
+    throw std::runtime_error("размер изображения не совпадает с сетью");
+  }
+  network_->Infer(pixels, 1 / Image::kMaxValue, output_.data());
+  auto it = std::max_element(output_.begin(), output_.end());
+  std::size_t max_ind = std::distance(output_.begin(), it);
   return {max_ind, *it};
 }
 
@@ -132,4 +389,8 @@ std::vector<double> NeuralNetwork::GetWeights() const {
   return network_->GetWeights();
 }
 
+void NeuralNetwork::CopyWeights(std::vector<double>* weights) const {
+  network_->CopyWeights(weights);
+}
+
 }  // namespace s21
@@ -2,6 +2,7 @@
 #define SRC_MODEL_NEURAL_NETWORK_NEURAL_NETWORK_H_
 
 #include <atomic>
+#include <chrono>  // NOLINT [build/c++11]
 #include <ctime>
 #include <fstream>
 #include <iomanip>
@@ -10,61 +11,169 @@
 #include <sstream>
 #include <vector>
 
+#include "../dataset.h"
 #include "../image.h"
 #include "../reader/csv_reader.h"
+#include "../thread_pool.h"
 #include "graph_network/graph_network.h"
 #include "io/weight_writer.h"
+#include "mapped_network/mapped_network.h"
 #include "matrix_network/matrix_network.h"
 #include "network_interface.h"
+#include "quantized_network/quantized_network.h"
 
 namespace s21 {
 
 class NeuralNetwork {
  public:
-  NeuralNetwork(NetworkType type, NetworkSettings settings)
-      : type_(type), settings_(settings) {
-    switch (type) {
-      case NetworkType::kMatrix:
-        network_ = std::make_unique<MatrixNetwork>(settings);
-        break;
-      case NetworkType::kGraph:
-        network_ = std::make_unique<GraphNetwork>(settings);
-        break;
-    }
-  }
+  NeuralNetwork(NetworkType type, NetworkSettings settings,
+                Precision precision = Precision::kDouble)
+      : NeuralNetwork(type, settings, precision,
+                      MakeNetwork(type, settings, precision)) {}
+
+  // Inference-only matrix network running on the weights of a mapped
+  // version 2 file, in the precision they were stored in; a kInt8 file gets
+  // a QuantizedNetwork and reports kFloat. Train throws; Test, Predict and
+  // GetWeights work as usual.
+  explicit NeuralNetwork(std::shared_ptr<const WeightFile> weights)
+      : NeuralNetwork(NetworkType::kMatrix, weights->GetSettings(),
+                      PrecisionOf(*weights), MakeNetwork(weights)) {}
 
-  void Train(const std::list<Image>& data, std::size_t epochs,
+  void Train(const Dataset& data, std::size_t epochs,
              double learning_rate = 0.15,
              std::function<void()> start_callback = nullptr,
              std::function<void(std::size_t)> epoch_progress_callback = nullptr,
              std::function<void(std::size_t)> epoch_end_callback = nullptr,
              std::function<void()> end_callback = nullptr,
              const std::atomic_bool& exit = std::atomic_bool(false));
-  void TrainEpoch(const std::list<Image>& data, double learning_rate,
+  void TrainEpoch(const Dataset& data, double learning_rate,
                   std::function<void(std::size_t)> epoch_progress_callback,
                   const std::atomic_bool& exit);
+  void TrainEpochHogwild(
+      const Dataset& data, double learning_rate,
+      std::function<void(std::size_t)> epoch_progress_callback,
+      const std::atomic_bool& exit);
 
   NetworkTestMetrics Test(
-      const std::list<Image>& data, double part,
+      const Dataset& data, double part,
       std::function<void()> start_callback = nullptr,
       std::function<void(std::size_t)> progress_callback = nullptr,
       std::function<void(NetworkTestMetrics)> end_callback = nullptr,
       const std::atomic_bool& exit = std::atomic_bool(false));
 
-  std::vector<double> Prediction(const Image& image);
-  std::pair<std::size_t, double> Predict(const Image& image);
+  std::pair<std::size_t, double> Predict(const ImageView& image);
+  // Classifies |size| raw pixels and returns the strongest output and its
+  // value, like Predict. Runs on the backend's Infer scratch state and
+  // buffers sized at construction, so it does not allocate and does not
+  // disturb a training pass. Not reentrant.
+  std::pair<std::size_t, double> Infer(const std::uint8_t* pixels,
+                                       std::size_t size);
 
   std::vector<double> GetWeights() const;
+  // Like GetWeights, reusing the capacity of |weights|.
+  void CopyWeights(std::vector<double>* weights) const;
   void SetWeights(const std::vector<double>& weights);
 
   NetworkType GetType() const { return type_; }
+  Precision GetPrecision() const { return precision_; }
   const NetworkSettings& GetSettings() const { return settings_; }
 
+  // Number of images per weight update. 1 is plain online SGD; larger
+  // batches average the gradient, so the learning rate may need scaling up.
+  std::size_t GetBatchSize() const { return batch_size_; }
+  void SetBatchSize(std::size_t batch_size) {
+    batch_size_ = std::max<std::size_t>(batch_size, 1);
+  }
+
+  // Number of threads every batch is sharded across; only used with batches
+  // larger than one image, by Hogwild training and by Test. Results are
+  // deterministic for a fixed thread count, but differ between counts by
+  // rounding because gradients are summed in a different order.
+  std::size_t GetThreads() const { return threads_; }
+  void SetThreads(std::size_t threads) {
+    threads_ = std::max<std::size_t>(threads, 1);
+    network_->SetThreads(threads_);
+  }
+
+  TrainMode GetTrainMode() const { return train_mode_; }
+  void SetTrainMode(TrainMode mode) { train_mode_ = mode; }
+
+  // Called by every Hogwild worker when it finishes its part of an epoch with
+  // the worker index and its samples per second. Runs on the worker thread.
+  void SetThroughputCallback(std::function<void(std::size_t, double)> cb) {
+    throughput_callback_ = std::move(cb);
+  }
+
  private:
-  std::vector<double> ExpectedOutput(const Image& image);
+  NeuralNetwork(NetworkType type, NetworkSettings settings,
+                Precision precision,
+                std::unique_ptr<NetworkInterface> network);
+  static std::unique_ptr<NetworkInterface> MakeNetwork(
+      NetworkType type, const NetworkSettings& settings, Precision precision);
+  static std::unique_ptr<NetworkInterface> MakeNetwork(
+      std::shared_ptr<const WeightFile> weights);
+  static Precision PrecisionOf(const WeightFile& weights);
+
+  const std::vector<double>& ExpectedOutput(int number) const;
+  // Both scale the 8-bit pixels of |image| to [0, 1] in a single pass: the
+  // first straight into the input layer, the second into |input| for the
+  // batched and Hogwild paths. Throw if the image does not fit the layer.
+  void SetInput(const ImageView& image);
+  void LoadInput(const ImageView& image, std::vector<double>* input) const;
+  void CheckImageSize(const ImageView& image) const;
+
+  // Outcome counts of the classification of a test set. The vectors are
+  // sized once per worker and cleared in place between calls.
+  struct TestCounts {
+    std::size_t true_pos = 0;
+    std::size_t true_neg = 0;
+    std::size_t false_pos = 0;
+    std::size_t false_neg = 0;
+    // Row-major, row = true class, column = strongest output.
+    std::vector<std::size_t> confusion;
+    // ranks[r]: samples whose class had exactly r stronger outputs, for
+    // r < kTopK.
+    std::vector<std::size_t> ranks;
+  };
+  // Buffers of one evaluation worker, kept between calls.
+  struct TestWorker {
+    std::vector<const std::uint8_t*> inputs;
+    std::vector<double> outputs;
+    TestCounts counts;
+  };
+  // Images per forward pass during Test.
+  static constexpr std::size_t kTestBatchSize = 64;
+  // Largest k reported in NetworkTestMetrics::top_k_accuracy.
+  static constexpr std::size_t kTopK = 5;
+
+  void ResetCounts(TestCounts* counts) const;
+  void Count(int number, const double* output, TestCounts* counts) const;
+  void FillMetrics(const TestCounts& counts,
+                   NetworkTestMetrics* metrics) const;
+  // Pool of |workers| threads for Hogwild training and evaluation, rebuilt
+  // only when the count changes.
+  ThreadPool& Pool(std::size_t workers);
 
   NetworkType type_;
+  Precision precision_;
   NetworkSettings settings_;
+  std::size_t batch_size_ = 1;
+  std::size_t threads_ = 1;
+  TrainMode train_mode_ = TrainMode::kSynchronous;
+  std::function<void(std::size_t, double)> throughput_callback_;
+  std::unique_ptr<ThreadPool> pool_;
+  std::vector<std::vector<double>> expected_outputs_;
+  // Output of the last Infer, reused so that it does not allocate.
+  std::vector<double> output_;
+  // Current mini-batch, kept between epochs to avoid reallocating.
+  std::vector<std::vector<double>> batch_storage_;
+  std::vector<const std::vector<double>*> batch_inputs_;
+  std::vector<const std::vector<double>*> batch_expected_outputs_;
+  // Input of each Hogwild worker.
+  std::vector<std::vector<double>> hogwild_inputs_;
+  std::vector<TestWorker> test_workers_;
+  // Totals over the workers of the last Test.
+  TestCounts test_counts_;
   std::unique_ptr<NetworkInterface> network_;
 };
 
@@ -0,0 +1,268 @@
+#include "quantized_network.h"
+
+namespace s21 {
+
+QuantizedNetwork QuantizedNetwork::Quantize(const std::vector<double> &weights,
+                                            const NetworkSettings &settings,
+                                            const Dataset &calibration,
+                                            std::size_t samples) {
+  if (weights.size() != WeightFile::WeightCount(settings)) {
+    throw std::runtime_error("веса сети отсутствуют");
+  }
+  const std::size_t count = std::min(samples, calibration.size());
+  if (count != 0 &&
+      calibration.GetImageSize() != settings.neurons_in_input_layer) {
+    throw std::runtime_error("размер изображения не совпадает с сетью");
+  }
+
+  std::vector<Layer> layers;
+  std::vector<const double *> matrices;
+  const double *matrix = weights.data();
+  std::size_t columns = settings.neurons_in_input_layer;
+  for (std::size_t i = 0; i <= settings.number_of_hidden_layers; i++) {
+    Layer layer;
+    layer.rows = i < settings.number_of_hidden_layers
+                     ? settings.neurons_in_hidden_layer
+                     : settings.neurons_in_output_layer;
+    layer.columns = columns;
+    matrices.push_back(matrix);
+    matrix += layer.rows * layer.columns;
+    columns = layer.rows;
+    layers.push_back(std::move(layer));
+  }
+
+  // The largest input every layer sees on the calibration images.
+  std::vector<double> maxima(layers.size(), 0);
+  std::vector<std::vector<double>> values(layers.size() + 1);
+  values[0].resize(settings.neurons_in_input_layer);
+  for (std::size_t i = 0; i < layers.size(); i++) {
+    values[i + 1].resize(layers[i].rows);
+  }
+  for (std::size_t s = 0; s < count; s++) {
+    kernels::ScaleBytes(values[0].size(), 1 / Image::kMaxValue,
+                        calibration[s * calibration.size() / count].Pixels(),
+                        values[0].data());
+    for (std::size_t i = 0; i < layers.size(); i++) {
+      maxima[i] = std::max(
+          maxima[i], *std::max_element(values[i].begin(), values[i].end()));
+      kernels::Gemv(layers[i].rows, layers[i].columns, matrices[i],
+                    layers[i].columns, values[i].data(), values[i + 1].data());
+      kernels::Sigmoid(layers[i].rows, values[i + 1].data(),
+                       values[i + 1].data());
+    }
+  }
+
+  for (std::size_t i = 0; i < layers.size(); i++) {
+    Layer &layer = layers[i];
+    layer.input_scale =
+        static_cast<float>((maxima[i] > 0 ? maxima[i] : 1) / 127);
+    layer.row_scales.resize(layer.rows);
+    layer.weights.resize(layer.rows * layer.columns);
+    for (std::size_t r = 0; r < layer.rows; r++) {
+      const double *row = matrices[i] + r * layer.columns;
+      double largest = 0;
+      for (std::size_t c = 0; c < layer.columns; c++) {
+        largest = std::max(largest, std::fabs(row[c]));
+      }
+      const float scale = static_cast<float>(largest > 0 ? largest / 127 : 1);
+      layer.row_scales[r] = scale;
+      for (std::size_t c = 0; c < layer.columns; c++) {
+        const long value = std::lround(row[c] / scale);
+        layer.weights[r * layer.columns + c] =
+            static_cast<std::int8_t>(std::clamp(value, -127L, 127L));
+      }
+    }
+  }
+  return QuantizedNetwork(settings, std::move(layers));
+}
+
+QuantizedNetwork::QuantizedNetwork(const WeightFile &file)
+    : QuantizedNetwork(file.GetSettings(), LoadLayers(file)) {}
+
+std::vector<QuantizedNetwork::Layer> QuantizedNetwork::LoadLayers(
+    const WeightFile &file) {
+  if (file.GetHeader().dtype != WeightFile::kInt8) {
+    throw std::runtime_error("некорректный формат файла");
+  }
+  const NetworkSettings settings = file.GetSettings();
+  const std::vector<float> scales = file.Scales();
+  const std::int8_t *weights = reinterpret_cast<const std::int8_t *>(
+      static_cast<const char *>(file.Payload()) +
+      WeightFile::QuantizedWeightsOffset(settings));
+  const float *row_scales =
+      scales.data() + settings.number_of_hidden_layers + 1;
+
+  std::vector<Layer> layers;
+  std::size_t columns = settings.neurons_in_input_layer;
+  for (std::size_t i = 0; i <= settings.number_of_hidden_layers; i++) {
+    Layer layer;
+    layer.rows = i < settings.number_of_hidden_layers
+                     ? settings.neurons_in_hidden_layer
+                     : settings.neurons_in_output_layer;
+    layer.columns = columns;
+    layer.input_scale = scales[i];
+    layer.row_scales.assign(row_scales, row_scales + layer.rows);
+    layer.weights.assign(weights, weights + layer.rows * layer.columns);
+    row_scales += layer.rows;
+    weights += layer.rows * layer.columns;
+    columns = layer.rows;
+    layers.push_back(std::move(layer));
+  }
+  return layers;
+}
+
+QuantizedNetwork::QuantizedNetwork(const NetworkSettings &settings,
+                                   std::vector<Layer> layers)
+    : settings_(settings), layers_(std::move(layers)) {
+  for (Layer &layer : layers_) {
+    layer.sum_scales.resize(layer.rows);
+    for (std::size_t r = 0; r < layer.rows; r++) {
+      layer.sum_scales[r] = layer.row_scales[r] * layer.input_scale;
+    }
+  }
+  single_ = MakeState();
+  infer_ = MakeState();
+}
+
+bool QuantizedNetwork::Save(const std::string &filename, std::size_t epoch,
+                            std::size_t accuracy) const {
+  std::vector<float> scales;
+  std::vector<std::int8_t> weights;
+  for (const Layer &layer : layers_) scales.push_back(layer.input_scale);
+  for (const Layer &layer : layers_) {
+    scales.insert(scales.end(), layer.row_scales.begin(),
+                  layer.row_scales.end());
+    weights.insert(weights.end(), layer.weights.begin(), layer.weights.end());
+  }
+  WeightFile::Header header =
+      WeightFile::MakeHeader(settings_, WeightFile::kInt8);
+  header.epoch = epoch;
+  header.accuracy = accuracy;
+  return WeightWriter::Write(
+      filename, header, WeightFile::EncodeQuantizedPayload(scales, weights));
+}
+
+QuantizedNetwork::State QuantizedNetwork::MakeState() const {
+  State state;
+  std::size_t widest = 0;
+  for (const Layer &layer : layers_) {
+    state.inputs.emplace_back(layer.columns);
+    widest = std::max(widest, layer.rows);
+  }
+  state.sums.resize(widest);
+  state.values.resize(widest);
+  state.output.resize(layers_.back().rows);
+  return state;
+}
+
+void QuantizedNetwork::Forward(State *state) const {
+  for (std::size_t i = 0; i < layers_.size(); i++) {
+    const Layer &layer = layers_[i];
+    kernels::GemvS8(layer.rows, layer.columns, layer.weights.data(),
+                    layer.columns, state->inputs[i].data(),
+                    state->sums.data());
+    for (std::size_t r = 0; r < layer.rows; r++) {
+      state->values[r] =
+          static_cast<float>(state->sums[r]) * layer.sum_scales[r];
+    }
+    kernels::Sigmoid(layer.rows, state->values.data(), state->values.data());
+    if (i + 1 < layers_.size()) {
+      const float inverse = 1 / layers_[i + 1].input_scale;
+      std::uint8_t *next = state->inputs[i + 1].data();
+      for (std::size_t r = 0; r < layer.rows; r++) {
+        next[r] = QuantizeActivation(state->values[r], inverse);
+      }
+    } else {
+      std::copy_n(state->values.begin(), layer.rows, state->output.begin());
+    }
+  }
+}
+
+// A byte has only 256 values, so pixels are quantized by table lookup.
+void QuantizedNetwork::QuantizeInput(const std::uint8_t *input, double scale,
+                                     State *state) const {
+  if (state->pixel_scale != scale) {
+    const float inverse =
+        static_cast<float>(scale) / layers_.front().input_scale;
+    for (int i = 0; i < 256; i++) {
+      state->pixels[i] = QuantizeActivation(static_cast<float>(i), inverse);
+    }
+    state->pixel_scale = scale;
+  }
+  std::vector<std::uint8_t> &values = state->inputs.front();
+  for (std::size_t i = 0; i < values.size(); i++) {
+    values[i] = state->pixels[input[i]];
+  }
+}
+
+void QuantizedNetwork::SetInput(const std::vector<double> &outputs) {
+  const float inverse = 1 / layers_.front().input_scale;
+  std::vector<std::uint8_t> &values = single_.inputs.front();
+  for (std::size_t i = 0; i < std::min(outputs.size(), values.size()); i++) {
+    values[i] = QuantizeActivation(static_cast<float>(outputs[i]), inverse);
+  }
+}
+
+void QuantizedNetwork::SetScaledInput(const std::uint8_t *input,
+                                      double scale) {
+  QuantizeInput(input, scale, &single_);
+}
+
+void QuantizedNetwork::ForwardPropagation() { Forward(&single_); }
+
+void QuantizedNetwork::BackPropagation(const std::vector<double> &, double) {
+  throw std::runtime_error("сеть загружена только для распознавания");
+}
+
+std::vector<double> QuantizedNetwork::GetOutput() { return single_.output; }
+
+void QuantizedNetwork::CopyOutput(double *output) const {
+  std::copy(single_.output.begin(), single_.output.end(), output);
+}
+
+std::size_t QuantizedNetwork::PrepareInference(std::size_t workers,
+                                               std::size_t) {
+  workers = std::max<std::size_t>(workers, 1);
+  while (inference_.size() < workers) inference_.push_back(MakeState());
+  return workers;
+}
+
+// Each sample is quantized and run through its own GEMVs.
+void QuantizedNetwork::PredictBatch(std::size_t worker,
+                                    const std::uint8_t *const *inputs,
+                                    std::size_t count, double scale,
+                                    double *outputs) {
+  State *state = &inference_[worker];
+  for (std::size_t b = 0; b < count; b++) {
+    QuantizeInput(inputs[b], scale, state);
+    Forward(state);
+    outputs = std::copy(state->output.begin(), state->output.end(), outputs);
+  }
+}
+
+void QuantizedNetwork::Infer(const std::uint8_t *input, double scale,
+                             double *output) {
+  QuantizeInput(input, scale, &infer_);
+  Forward(&infer_);
+  std::copy(infer_.output.begin(), infer_.output.end(), output);
+}
+
+std::vector<double> QuantizedNetwork::GetWeights() {
+  std::vector<double> weights;
+  for (const Layer &layer : layers_) {
+    for (std::size_t r = 0; r < layer.rows; r++) {
+      for (std::size_t c = 0; c < layer.columns; c++) {
+        weights.push_back(
+            static_cast<float>(layer.weights[r * layer.columns + c]) *
+            layer.row_scales[r]);
+      }
+    }
+  }
+  return weights;
+}
+
+void QuantizedNetwork::LoadWeights(const std::vector<double> &) {
+  throw std::runtime_error("сеть загружена только для распознавания");
+}
+
+}  // namespace s21
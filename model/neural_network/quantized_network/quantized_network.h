@@ -0,0 +1,118 @@
+#ifndef SRC_MODEL_NEURAL_NETWORK_QUANTIZED_NETWORK_QUANTIZED_NETWORK_H_
+#define SRC_MODEL_NEURAL_NETWORK_QUANTIZED_NETWORK_QUANTIZED_NETWORK_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../../../lib/matrixplus/s21_kernels.h"
+#include "../../dataset.h"
+#include "../../image.h"
+#include "../io/weight_file.h"
+#include "../io/weight_writer.h"
+#include "../network_interface.h"
+
+namespace s21 {
+
+// Inference-only perceptron with int8 weights and 7-bit unsigned
+// activations, built from a trained network by Quantize. Every layer sums
+// its inputs with kernels::GemvS8 and rescales the 32-bit sums to float:
+//
+//   z[r] = row_scale[r] * input_scale * sum(w[r][c] * x[c])
+//
+// then applies the sigmoid and requantizes the result with the input scale
+// of the next layer. Weight rows get a symmetric scale, max |w| / 127;
+// layer inputs a scale of the largest value seen during calibration over
+// 127. Training calls throw std::runtime_error.
+class QuantizedNetwork : public NetworkInterface {
+ public:
+  // Quantizes |weights|, in the order of NetworkInterface::GetWeights, of a
+  // network with |settings|. The input scales are calibrated on the double
+  // precision forward pass over up to |samples| images spread evenly over
+  // |calibration|.
+  static QuantizedNetwork Quantize(const std::vector<double>& weights,
+                                   const NetworkSettings& settings,
+                                   const Dataset& calibration,
+                                   std::size_t samples);
+  // Loads a kInt8 weight file.
+  explicit QuantizedNetwork(const WeightFile& file);
+  ~QuantizedNetwork() = default;
+
+  // Writes a kInt8 weight file. Returns false if it could not be written.
+  bool Save(const std::string& filename,
+            std::size_t epoch = std::string::npos,
+            std::size_t accuracy = std::string::npos) const;
+
+  void SetInput(const std::vector<double>& outputs) override;
+  void SetScaledInput(const std::uint8_t* input, double scale) override;
+  void ForwardPropagation() override;
+  void BackPropagation(const std::vector<double>& expected_output,
+                       double learning_rate_) override;
+  std::vector<double> GetOutput() override;
+  void CopyOutput(double* output) const override;
+
+  std::size_t PrepareInference(std::size_t workers,
+                               std::size_t batch) override;
+  void PredictBatch(std::size_t worker, const std::uint8_t* const* inputs,
+                    std::size_t count, double scale,
+                    double* outputs) override;
+  void Infer(const std::uint8_t* input, double scale,
+             double* output) override;
+
+  // The dequantized weights.
+  std::vector<double> GetWeights() override;
+  void LoadWeights(const std::vector<double>& weights) override;
+
+ private:
+  struct Layer {
+    std::size_t rows = 0;
+    std::size_t columns = 0;
+    float input_scale = 0;
+    std::vector<float> row_scales;
+    // rows x columns, row-major.
+    std::vector<std::int8_t> weights;
+    // row_scales[r] * input_scale, applied to the sums of row r.
+    std::vector<float> sum_scales;
+  };
+  // Quantized inputs of every layer and the scratch of one pass.
+  struct State {
+    // Quantized value of every pixel byte at |pixel_scale|, rebuilt when
+    // the scale changes.
+    std::uint8_t pixels[256] = {};
+    double pixel_scale = 0;
+    std::vector<std::vector<std::uint8_t>> inputs;
+    std::vector<std::int32_t> sums;
+    std::vector<float> values;
+    std::vector<double> output;
+  };
+
+  QuantizedNetwork(const NetworkSettings& settings, std::vector<Layer> layers);
+  static std::vector<Layer> LoadLayers(const WeightFile& file);
+
+  State MakeState() const;
+  void Forward(State* state) const;
+  // Writes |input| scaled by |scale| into the quantized input of |state|.
+  void QuantizeInput(const std::uint8_t* input, double scale,
+                     State* state) const;
+
+  static std::uint8_t QuantizeActivation(float value, float inverse_scale) {
+    return static_cast<std::uint8_t>(
+        std::min(127.0f, std::max(0.0f, value * inverse_scale) + 0.5f));
+  }
+
+  NetworkSettings settings_;
+  std::vector<Layer> layers_;
+  // State of SetInput/ForwardPropagation/GetOutput.
+  State single_;
+  // One state per inference worker.
+  std::vector<State> inference_;
+  // State of Infer.
+  State infer_;
+};
+
+}  // namespace s21
+
+#endif  // SRC_MODEL_NEURAL_NETWORK_QUANTIZED_NETWORK_QUANTIZED_NETWORK_H_
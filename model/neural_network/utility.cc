@@ -2,16 +2,50 @@
 
 namespace s21::utility {
 
+namespace {
+
+std::uint64_t EntropySeed() {
+  std::random_device device;
+  return (static_cast<std::uint64_t>(device()) << 32) | device();
+}
+
+// Generator of the calling thread, created on first use.
+Random& ThreadRandom() {
+  thread_local Random random(EntropySeed());
+  return random;
+}
+
+}  // namespace
+
 double DerivativeActivFunc(double x) { return x * (1.0 - x); }
 
 double ActivationFunc(double x) { return 1.0 / (1.0 + exp(-x)); }
 
-double RandomWeight() {
-  std::random_device rd;
-  std::default_random_engine eng(rd());
-  std::uniform_real_distribution<double> distr(-1, 1);
+// The state is expanded from the seed with splitmix64, as the xoshiro authors
+// recommend, so that nearby seeds give unrelated streams.
+Random::Random(std::uint64_t seed) {
+  for (std::uint64_t& word : state_) {
+    std::uint64_t z = (seed += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    word = z ^ (z >> 31);
+  }
+}
+
+void SeedRandom(std::uint64_t seed) { ThreadRandom() = Random(seed); }
+
+double RandomWeight() { return ThreadRandom().NextWeight(); }
+
+void FillRandom(double* values, std::size_t size) {
+  Random& random = ThreadRandom();
+  for (std::size_t i = 0; i < size; i++) values[i] = random.NextWeight();
+}
 
-  return distr(eng);
+void FillRandom(float* values, std::size_t size) {
+  Random& random = ThreadRandom();
+  for (std::size_t i = 0; i < size; i++) {
+    values[i] = static_cast<float>(random.NextWeight());
+  }
 }
 
 }  // namespace s21::utility
@@ -2,6 +2,8 @@
 #define SRC_MODEL_NEURAL_NETWORK_UTILITY_H_
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <random>
 
 namespace s21::utility {
@@ -10,8 +12,49 @@ double DerivativeActivFunc(double x);
 
 double ActivationFunc(double x);
 
+// xoshiro256** by Blackman and Vigna: four words of state, a few shifts and
+// multiplies per number, and far better statistics than the weights need.
+class Random {
+ public:
+  explicit Random(std::uint64_t seed);
+
+  std::uint64_t Next() {
+    const std::uint64_t result = RotateLeft(state_[1] * 5, 7) * 9;
+    const std::uint64_t t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = RotateLeft(state_[3], 45);
+    return result;
+  }
+
+  // Uniform in [-1, 1), using the top 53 bits of Next().
+  double NextWeight() {
+    return static_cast<double>(Next() >> 11) * 0x1.0p-52 - 1;
+  }
+
+ private:
+  static std::uint64_t RotateLeft(std::uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  std::uint64_t state_[4];
+};
+
+// Restarts the generator of the calling thread from |seed|, so the weights
+// of networks built afterwards on this thread are reproducible. A thread that
+// never called it draws a seed from std::random_device on first use.
+void SeedRandom(std::uint64_t seed);
+
+// Uniform in [-1, 1) from the generator of the calling thread.
 double RandomWeight();
 
+// Fills |size| values at |values| with RandomWeight().
+void FillRandom(double* values, std::size_t size);
+void FillRandom(float* values, std::size_t size);
+
 }  // namespace s21::utility
 
 #endif  // SRC_MODEL_NEURAL_NETWORK_UTILITY_H_
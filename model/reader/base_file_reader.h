@@ -5,6 +5,7 @@
 #include <list>
 #include <string>
 
+#include "../dataset.h"
 #include "../image.h"
 
 namespace s21 {
@@ -13,7 +14,7 @@ class BaseFileReader {
  public:
   virtual ~BaseFileReader() = default;
 
-  virtual std::list<Image> Read(const std::string& filename) = 0;
+  virtual Dataset Read(const std::string& filename) = 0;
 };
 
 }  // namespace s21
@@ -2,30 +2,106 @@
 
 namespace s21 {
 
-std::list<Image> CsvReader::Read(const std::string& filename) {
-#ifdef DEBUG
-  auto start_time = std::chrono::high_resolution_clock::now();
+namespace {
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define S21_CSV_SWAR
+#endif
+
+#ifdef S21_CSV_SWAR
+const std::uint64_t kPowersOf10[] = {1,      10,      100,      1000,     10000,
+                                     100000, 1000000, 10000000, 100000000};
+
+// Value of eight decimal digits, already reduced to 0..9, with the most
+// significant one in the lowest byte: adjacent digits are combined into
+// pairs, pairs into quads and quads into the result.
+std::uint64_t EightDigits(std::uint64_t chunk) {
+  chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FF;
+  chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFF;
+  return (chunk * 10000 + (chunk >> 32)) & 0xFFFFFFFF;
+}
+#endif
+
+// Parses the run of decimal digits at |p| into |value| and returns the first
+// byte after it, or |p| itself if there is no digit.
+const char* ParseDigits(const char* p, const char* end, std::uint64_t* value) {
+  std::uint64_t result = 0;
+#ifdef S21_CSV_SWAR
+  while (end - p >= 8) {
+    std::uint64_t chunk;
+    std::memcpy(&chunk, p, sizeof(chunk));
+    chunk -= 0x3030303030303030;
+    // A byte is a digit iff it is 0..9 after subtracting '0'; borrows and
+    // carries only move towards later bytes, so the first flag is exact.
+    std::uint64_t non_digits =
+        (chunk | (chunk + 0x7676767676767676)) & 0x8080808080808080;
+    std::size_t digits =
+        non_digits ? static_cast<std::size_t>(__builtin_ctzll(non_digits)) / 8
+                   : 8;
+    if (digits == 0) break;
+
+    chunk <<= 8 * (8 - digits);
+    result = result * kPowersOf10[digits] + EightDigits(chunk);
+    p += digits;
+    if (digits < 8) {
+      *value = result;
+      return p;
+    }
+  }
 #endif
+  for (; p < end && *p >= '0' && *p <= '9'; p++) {
+    result = result * 10 + static_cast<std::uint64_t>(*p - '0');
+  }
+  *value = result;
+  return p;
+}
 
-  std::list<Image> images;
+bool IsFieldEnd(const char* p, const char* end) {
+  return p == end || *p == ',';
+}
 
-  std::ifstream file(filename);
-  if (file.is_open()) {
-    std::string data;
-    while (std::getline(file, data)) {
-      Image image;
+const char* FindLineEnd(const char* begin, const char* end) {
+  const char* line_end = static_cast<const char*>(
+      std::memchr(begin, '\n', static_cast<std::size_t>(end - begin)));
+  return line_end ? line_end : end;
+}
 
-      std::size_t i = 0;
-      image.char_number_ = ReadInt(data, i, &i);
+// Number of lines in [begin, end); the last one may lack its '\n'.
+std::size_t CountLines(const char* begin, const char* end) {
+  std::size_t lines = 0;
+  for (const char* p = begin; p < end; p = FindLineEnd(p, end) + 1) lines++;
+  return lines;
+}
+
+}  // namespace
+
+Dataset CsvReader::Read(const std::string& filename) {
+#ifdef DEBUG
+  auto start_time = std::chrono::high_resolution_clock::now();
+#endif
 
-      while (i < data.length()) {
-        image.data_.push_back(ReadDouble(data, i, &i));
-      }
-      images.push_back(image);
+  Dataset dataset;
+  std::unique_ptr<DatasetCache> cache =
+      use_cache_ ? DatasetCache::Open(filename) : nullptr;
+  if (cache) {
+    // The cache may have been written by a reader with more classes.
+    if (std::any_of(cache->Labels(), cache->Labels() + cache->GetCount(),
+                    [this](std::uint8_t label) {
+                      return label == 0 || label > classes_;
+                    })) {
+      throw std::runtime_error("некорректный формат данных");
     }
-    file.close();
+    const DatasetCache* mapping = cache.get();
+    dataset = Dataset(std::shared_ptr<const DatasetCache>(std::move(cache)),
+                      mapping->GetImageSize(), mapping->GetCount(),
+                      mapping->Pixels(), mapping->Labels());
   } else {
-    throw std::runtime_error("файл не найден");
+    dataset = Parse(filename);
+    if (use_cache_ && !dataset.empty()) {
+      DatasetCache::Write(filename, dataset.size(), dataset.GetImageSize(),
+                          dataset.Pixels(), dataset.Labels());
+    }
   }
 
 #ifdef DEBUG
@@ -38,33 +114,125 @@ std::list<Image> CsvReader::Read(const std::string& filename) {
             << " ms." << std::endl;
 #endif
 
-  return images;
+  return dataset;
 }
 
-int CsvReader::ReadInt(const std::string& data, std::size_t start_pos,
-                       std::size_t* end_pos) {
-  std::size_t bias = 0;
-  int value;
-  try {
-    value = std::stoi(data.substr(start_pos), &bias);
-  } catch (const std::invalid_argument& e) {
-    throw std::runtime_error("некорректный формат данных");
+Dataset CsvReader::Parse(const std::string& filename) {
+  MappedFile file(filename);
+  const char* const begin = file.Data();
+  const char* const end = begin + file.Size();
+  if (begin == end) return Dataset();
+
+  // The first row fixes the image size for the whole file; it cannot have
+  // more fields than characters.
+  const char* first_end = FindLineEnd(begin, end);
+  std::vector<std::uint8_t> first_row(
+      static_cast<std::size_t>(first_end - begin));
+  std::uint8_t label;
+  const std::size_t image_size =
+      ParseLine(begin, first_end, &label, first_row.data(), first_row.size());
+
+  const std::size_t chunks =
+      std::min(threads_, std::max<std::size_t>(file.Size() / kMinChunkSize, 1));
+  if (chunks == 1) {
+    const std::size_t rows = CountLines(begin, end);
+    std::vector<std::uint8_t> pixels(rows * image_size);
+    std::vector<std::uint8_t> labels(rows);
+    ParseChunk(begin, end, image_size, classes_, labels.data(),
+               pixels.data());
+    return Dataset(image_size, std::move(pixels), std::move(labels));
+  }
+
+  // Chunk i is [bounds[i], bounds[i + 1]); every inner bound is moved to the
+  // start of the next line.
+  std::vector<const char*> bounds(chunks + 1, end);
+  bounds[0] = begin;
+  for (std::size_t i = 1; i < chunks; i++) {
+    const char* p = std::max(begin + file.Size() * i / chunks, bounds[i - 1]);
+    bounds[i] = std::min(FindLineEnd(p, end) + 1, end);
+  }
+
+  std::lock_guard<std::mutex> lock(pool_mutex_);
+  ThreadPool& pool = Pool();
+  // Chunk i starts at row first_rows[i] of the dataset.
+  std::vector<std::size_t> first_rows(chunks + 1, 0);
+  pool.Run([&](std::size_t i) {
+    if (i < chunks) first_rows[i + 1] = CountLines(bounds[i], bounds[i + 1]);
+  });
+  for (std::size_t i = 0; i < chunks; i++) first_rows[i + 1] += first_rows[i];
+
+  std::vector<std::uint8_t> pixels(first_rows[chunks] * image_size);
+  std::vector<std::uint8_t> labels(first_rows[chunks]);
+  std::vector<std::exception_ptr> errors(chunks);
+  pool.Run([&](std::size_t i) {
+    if (i >= chunks) return;
+    try {
+      ParseChunk(bounds[i], bounds[i + 1], image_size, classes_,
+                 labels.data() + first_rows[i],
+                 pixels.data() + first_rows[i] * image_size);
+    } catch (...) {
+      errors[i] = std::current_exception();
+    }
+  });
+
+  for (std::size_t i = 0; i < chunks; i++) {
+    if (errors[i]) std::rethrow_exception(errors[i]);
+  }
+  return Dataset(image_size, std::move(pixels), std::move(labels));
+}
+
+ThreadPool& CsvReader::Pool() {
+  if (!pool_ || pool_->GetThreads() != threads_) {
+    pool_ = std::make_unique<ThreadPool>(threads_);
+  }
+  return *pool_;
+}
+
+// Labels are checked here, before they reach NeuralNetwork::ExpectedOutput
+// on a training thread.
+void CsvReader::ParseChunk(const char* begin, const char* end,
+                           std::size_t image_size, std::size_t classes,
+                           std::uint8_t* labels, std::uint8_t* pixels) {
+  while (begin < end) {
+    const char* line_end = FindLineEnd(begin, end);
+    if (ParseLine(begin, line_end, labels, pixels, image_size) !=
+            image_size ||
+        *labels == 0 || *labels > classes) {
+      throw std::runtime_error("некорректный формат данных");
+    }
+    labels++;
+    pixels += image_size;
+    begin = line_end + 1;
+  }
+}
+
+std::size_t CsvReader::ParseLine(const char* begin, const char* end,
+                                 std::uint8_t* label, std::uint8_t* pixels,
+                                 std::size_t capacity) {
+  if (begin != end && end[-1] == '\r') end--;
+
+  std::size_t count = 0;
+  const char* p = ReadByte(begin, end, label);
+  while (p != end) {
+    // Skip the ','. A trailing one leaves an empty field, which ReadByte
+    // rejects like any other.
+    p++;
+    if (count == capacity) return capacity + 1;
+    p = ReadByte(p, end, pixels + count);
+    count++;
   }
-  *end_pos = start_pos + bias + 1;
-  return value;
+  return count;
 }
 
-double CsvReader::ReadDouble(const std::string& data, std::size_t start_pos,
-                             std::size_t* end_pos) {
-  std::size_t bias = 0;
-  double value;
-  try {
-    value = std::stod(data.substr(start_pos), &bias);
-  } catch (const std::invalid_argument& e) {
+const char* CsvReader::ReadByte(const char* begin, const char* end,
+                                std::uint8_t* value) {
+  std::uint64_t digits;
+  const char* p = ParseDigits(begin, end, &digits);
+  if (p == begin || p - begin > 3 || digits > 255 || !IsFieldEnd(p, end)) {
     throw std::runtime_error("некорректный формат данных");
   }
-  *end_pos = start_pos + bias + 1;
-  return value;
+  *value = static_cast<std::uint8_t>(digits);
+  return p;
 }
 
 }  // namespace s21
@@ -6,28 +6,85 @@
 #include <iostream>
 #endif
 
+#include <algorithm>
 #include <clocale>
+#include <cstdint>
+#include <cstring>
+#include <exception>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <thread>  // NOLINT [build/c++11]
 #include <type_traits>
 
+#include "../thread_pool.h"
 #include "base_file_reader.h"
+#include "dataset_cache.h"
+#include "mapped_file.h"
 
 namespace s21 {
 
+// Reads "label,pixel,pixel,..." rows of 8-bit values, all rows with the same
+// number of pixels, into a Dataset. The file is memory-mapped and parsed in
+// place with a SWAR digit scanner that handles eight characters per step;
+// anything that is not an integer in [0, 255], or a label outside
+// [1, classes], is a format error.
+//
+// Large files are cut into newline-aligned chunks. The rows of every chunk
+// are counted first, and then each chunk is parsed on its own thread
+// straight into its range of the dataset, so the result does not depend on
+// the thread count. If several chunks are malformed, the error of the first
+// one is thrown.
+//
+// With the cache enabled the dataset is also saved as a binary DatasetCache
+// sidecar, and later reads of the unchanged file map that directly: no
+// parsing and no copy of the pixels.
 class CsvReader : public BaseFileReader {
  public:
-  CsvReader() = default;
+  explicit CsvReader(std::size_t threads = std::thread::hardware_concurrency(),
+                     bool use_cache = false,
+                     std::size_t classes = Image::kLetters)
+      : threads_(std::max<std::size_t>(threads, 1)),
+        use_cache_(use_cache),
+        classes_(classes) {}
   ~CsvReader() = default;
 
-  std::list<Image> Read(const std::string& filename) override;
+  Dataset Read(const std::string& filename) override;
+
+  std::size_t GetThreads() const { return threads_; }
+  void SetThreads(std::size_t threads) {
+    threads_ = std::max<std::size_t>(threads, 1);
+  }
 
  private:
-  int ReadInt(const std::string& data, std::size_t start_pos,
-              std::size_t* end_pos);
-  double ReadDouble(const std::string& data, std::size_t start_pos,
-                    std::size_t* end_pos);
+  // Files below this size are parsed on the calling thread.
+  static const std::size_t kMinChunkSize = 1 << 20;
+
+  Dataset Parse(const std::string& filename);
+  // Pool of threads_ threads for chunked parsing, rebuilt only when the
+  // count changes. Callers hold pool_mutex_.
+  ThreadPool& Pool();
+
+  // Parses the lines of [begin, end) into consecutive labels and rows of
+  // |image_size| pixels.
+  static void ParseChunk(const char* begin, const char* end,
+                         std::size_t image_size, std::size_t classes,
+                         std::uint8_t* labels, std::uint8_t* pixels);
+  // Writes at most |capacity| pixels of one line and returns how many the
+  // line has, or capacity + 1 if it has more.
+  static std::size_t ParseLine(const char* begin, const char* end,
+                               std::uint8_t* label, std::uint8_t* pixels,
+                               std::size_t capacity);
+  static const char* ReadByte(const char* begin, const char* end,
+                              std::uint8_t* value);
+
+  std::size_t threads_;
+  bool use_cache_;
+  std::size_t classes_;
+  std::unique_ptr<ThreadPool> pool_;
+  // Model reads its train and test sets on separate threads.
+  std::mutex pool_mutex_;
 };
 
 }  // namespace s21
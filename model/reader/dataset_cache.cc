@@ -0,0 +1,154 @@
+#include "dataset_cache.h"
+
+namespace s21 {
+
+namespace {
+
+const char kMagic[8] = {'S', '2', '1', 'D', 'S', 'E', 'T', '\0'};
+
+std::size_t AlignUp(std::size_t offset) { return (offset + 63) / 64 * 64; }
+
+using io::LoadLe;
+using io::StoreLe;
+using io::WriteAll;
+
+}  // namespace
+
+std::string DatasetCache::CachePath(const std::string& source) {
+  return source + ".s21cache";
+}
+
+std::size_t DatasetCache::PixelsOffset(const Header& header) {
+  return AlignUp(kHeaderSize + header.path_size);
+}
+
+void DatasetCache::Encode(const Header& header, char* out) {
+  std::memcpy(out, header.magic, sizeof(header.magic));
+  StoreLe(header.version, out + 8);
+  StoreLe(header.label_type, out + 12);
+  StoreLe(header.count, out + 16);
+  StoreLe(header.image_size, out + 24);
+  StoreLe(header.source_size, out + 32);
+  StoreLe(static_cast<std::uint64_t>(header.source_mtime), out + 40);
+  StoreLe(header.path_size, out + 48);
+  StoreLe(header.reserved, out + 56);
+}
+
+DatasetCache::Header DatasetCache::Decode(const char* data) {
+  Header header;
+  std::memcpy(header.magic, data, sizeof(header.magic));
+  header.version = LoadLe<std::uint32_t>(data + 8);
+  header.label_type = LoadLe<std::uint32_t>(data + 12);
+  header.count = LoadLe<std::uint64_t>(data + 16);
+  header.image_size = LoadLe<std::uint64_t>(data + 24);
+  header.source_size = LoadLe<std::uint64_t>(data + 32);
+  header.source_mtime =
+      static_cast<std::int64_t>(LoadLe<std::uint64_t>(data + 40));
+  header.path_size = LoadLe<std::uint64_t>(data + 48);
+  header.reserved = LoadLe<std::uint64_t>(data + 56);
+  return header;
+}
+
+std::size_t DatasetCache::LabelsOffset(const Header& header) {
+  return AlignUp(PixelsOffset(header) + header.count * header.image_size);
+}
+
+// Fills the key fields of |header| from the current state of |source|.
+bool DatasetCache::DescribeSource(const std::string& source, Header* header,
+                                  std::string* path) {
+  namespace fs = std::filesystem;
+  std::error_code error;
+  *path = fs::weakly_canonical(source, error).string();
+  std::uintmax_t size = fs::file_size(source, error);
+  if (error) return false;
+  fs::file_time_type mtime = fs::last_write_time(source, error);
+  if (error) return false;
+
+  std::memcpy(header->magic, kMagic, sizeof(kMagic));
+  header->version = kVersion;
+  header->label_type = kLabelsUint8;
+  header->source_size = size;
+  header->source_mtime = static_cast<std::int64_t>(
+      mtime.time_since_epoch().count());
+  header->path_size = path->size();
+  header->reserved = 0;
+  return true;
+}
+
+std::unique_ptr<DatasetCache> DatasetCache::Open(const std::string& source) {
+  Header expected;
+  std::string path;
+  if (!DescribeSource(source, &expected, &path)) return nullptr;
+
+  std::unique_ptr<DatasetCache> cache;
+  try {
+    cache.reset(new DatasetCache(CachePath(source)));
+  } catch (const std::runtime_error&) {
+    return nullptr;
+  }
+
+  const MappedFile& file = cache->file_;
+  Header& header = cache->header_;
+  if (file.Size() < kHeaderSize) return nullptr;
+  header = Decode(file.Data());
+  if (std::memcmp(header.magic, expected.magic, sizeof(kMagic)) != 0 ||
+      header.version != expected.version ||
+      header.label_type != expected.label_type ||
+      header.source_size != expected.source_size ||
+      header.source_mtime != expected.source_mtime ||
+      header.path_size != expected.path_size ||
+      file.Size() < kHeaderSize + header.path_size ||
+      path.compare(0, path.size(), file.Data() + kHeaderSize,
+                   header.path_size) != 0 ||
+      header.image_size == 0 ||
+      header.count > file.Size() / header.image_size ||
+      file.Size() < LabelsOffset(header) + header.count) {
+    return nullptr;
+  }
+  return cache;
+}
+
+bool DatasetCache::Write(const std::string& source, std::size_t count,
+                         std::size_t image_size, const std::uint8_t* pixels,
+                         const std::uint8_t* labels) {
+  Header header;
+  std::string path;
+  if (!DescribeSource(source, &header, &path)) return false;
+  header.count = count;
+  header.image_size = image_size;
+
+  const std::string cache_path = CachePath(source);
+  std::string temp_path;
+  int fd = io::CreateTemporary(cache_path, &temp_path);
+  if (fd < 0) return false;
+
+  char encoded[kHeaderSize];
+  Encode(header, encoded);
+  const char padding[64] = {};
+  const std::size_t pixels_end = PixelsOffset(header) + count * image_size;
+  bool written =
+      WriteAll(fd, encoded, sizeof(encoded)) &&
+      WriteAll(fd, path.data(), path.size()) &&
+      WriteAll(fd, padding, PixelsOffset(header) - kHeaderSize - path.size()) &&
+      WriteAll(fd, pixels, count * image_size) &&
+      WriteAll(fd, padding, LabelsOffset(header) - pixels_end) &&
+      WriteAll(fd, labels, count);
+  written = close(fd) == 0 && written;
+  if (!written || std::rename(temp_path.c_str(), cache_path.c_str()) != 0) {
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+const std::uint8_t* DatasetCache::Pixels() const {
+  return reinterpret_cast<const std::uint8_t*>(file_.Data()) +
+         PixelsOffset(header_);
+}
+
+const std::uint8_t* DatasetCache::Labels() const {
+  return reinterpret_cast<const std::uint8_t*>(file_.Data()) +
+         LabelsOffset(header_);
+}
+
+}  // namespace s21
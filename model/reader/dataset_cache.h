@@ -0,0 +1,85 @@
+#ifndef SRC_MODEL_READER_DATASET_CACHE_H_
+#define SRC_MODEL_READER_DATASET_CACHE_H_
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "../io_util.h"
+#include "mapped_file.h"
+
+namespace s21 {
+
+// Binary sidecar of a parsed dataset, stored next to the source file as
+// <source>.s21cache:
+//
+//   Header (64 bytes, little-endian)
+//   source path (Header::path_size bytes)
+//   pixels: count x image_size uint8
+//   labels: count uint8
+//
+// Both arrays start at 64-byte boundaries. A cache is valid only for the
+// source path, size and modification time recorded in its header; anything
+// else, including a truncated or foreign file, makes Open return nullptr.
+class DatasetCache {
+ public:
+  static constexpr std::uint32_t kVersion = 1;
+  static constexpr std::uint32_t kLabelsUint8 = 1;
+  static constexpr std::size_t kHeaderSize = 64;
+
+  // In-memory form of the header; Encode and Decode convert it field by
+  // field, so the file layout does not depend on the host.
+  struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t label_type;
+    std::uint64_t count;
+    std::uint64_t image_size;
+    std::uint64_t source_size;
+    std::int64_t source_mtime;
+    std::uint64_t path_size;
+    std::uint64_t reserved;
+  };
+
+  static std::string CachePath(const std::string& source);
+
+  // Maps the cache of |source| if it is up to date.
+  static std::unique_ptr<DatasetCache> Open(const std::string& source);
+  // Writes the cache of |source| through a uniquely named temporary file and
+  // a rename, so readers never see a partial file and concurrent writers do
+  // not clobber each other. Returns false if it could not be written; the
+  // dataset is then simply parsed again next time.
+  static bool Write(const std::string& source, std::size_t count,
+                    std::size_t image_size, const std::uint8_t* pixels,
+                    const std::uint8_t* labels);
+
+  std::size_t GetCount() const { return header_.count; }
+  std::size_t GetImageSize() const { return header_.image_size; }
+  const std::uint8_t* Pixels() const;
+  const std::uint8_t* Labels() const;
+
+ private:
+  explicit DatasetCache(const std::string& path) : file_(path) {}
+
+  // Offsets of the arrays, each rounded up to a 64-byte boundary.
+  static std::size_t PixelsOffset(const Header& header);
+  static std::size_t LabelsOffset(const Header& header);
+  static void Encode(const Header& header, char* out);
+  static Header Decode(const char* data);
+  static bool DescribeSource(const std::string& source, Header* header,
+                             std::string* path);
+
+  MappedFile file_;
+  Header header_;
+};
+
+}  // namespace s21
+
+#endif  // SRC_MODEL_READER_DATASET_CACHE_H_
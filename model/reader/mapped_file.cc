@@ -0,0 +1,30 @@
+#include "mapped_file.h"
+
+namespace s21 {
+
+MappedFile::MappedFile(const std::string& filename, int advice) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  struct stat info;
+  if (fd < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+    if (fd >= 0) close(fd);
+    throw std::runtime_error("файл не найден");
+  }
+
+  size_ = static_cast<std::size_t>(info.st_size);
+  if (size_ != 0) {
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("не удалось прочитать файл");
+    }
+    madvise(data, size_, advice);
+    data_ = static_cast<const char*>(data);
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_) munmap(const_cast<char*>(data_), size_);
+}
+
+}  // namespace s21
@@ -0,0 +1,38 @@
+#ifndef SRC_MODEL_READER_MAPPED_FILE_H_
+#define SRC_MODEL_READER_MAPPED_FILE_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+namespace s21 {
+
+// Read-only memory mapping of a whole file, unmapped on destruction. An empty
+// file maps to Data() == nullptr and Size() == 0. |advice| is passed to
+// madvise: sequential for data read once, MADV_WILLNEED for data that is
+// read repeatedly and should be paged in up front.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& filename,
+                      int advice = MADV_SEQUENTIAL);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* Data() const { return data_; }
+  std::size_t Size() const { return size_; }
+
+ private:
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+}  // namespace s21
+
+#endif  // SRC_MODEL_READER_MAPPED_FILE_H_
@@ -0,0 +1,80 @@
+#include "thread_pool.h"
+
+namespace s21 {
+
+ThreadPool::ThreadPool(std::size_t threads) {
+  for (std::size_t i = 1; i < threads; i++) {
+    workers_.emplace_back(&ThreadPool::Work, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+}
+
+void ThreadPool::RunTask(TaskFunction function, const void* task) {
+  if (workers_.empty()) {
+    function(task, 0);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    function_ = function;
+    task_ = task;
+    pending_ = workers_.size();
+    generation_++;
+  }
+  start_.notify_all();
+  try {
+    function(task, 0);
+  } catch (...) {
+    SetError(std::current_exception());
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return pending_ == 0; });
+  task_ = nullptr;
+  if (error_) {
+    std::exception_ptr error = std::move(error_);
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void ThreadPool::SetError(std::exception_ptr error) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!error_) error_ = std::move(error);
+}
+
+void ThreadPool::Work(std::size_t index) {
+  std::size_t seen = 0;
+  while (true) {
+    TaskFunction function;
+    const void* task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_.wait(lock, [this, seen] { return stop_ || generation_ != seen; });
+      if (stop_) return;
+      seen = generation_;
+      function = function_;
+      task = task_;
+    }
+    try {
+      function(task, index);
+    } catch (...) {
+      SetError(std::current_exception());
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_--;
+    }
+    done_.notify_one();
+  }
+}
+
+}  // namespace s21
@@ -0,0 +1,63 @@
+#ifndef SRC_MODEL_THREAD_POOL_H_
+#define SRC_MODEL_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace s21 {
+
+// Fixed set of threads that run one task per thread and wait for all of them.
+// Thread i always gets index i and the caller itself runs index 0, so work
+// split by index is assigned the same way on every run.
+class ThreadPool {
+ public:
+  explicit ThreadPool(std::size_t threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  std::size_t GetThreads() const { return workers_.size() + 1; }
+
+  // Calls task(i) for every i in [0, GetThreads()) in parallel and returns
+  // once all calls have finished. The task is passed by reference and never
+  // copied, so running a capturing lambda does not allocate. If a call
+  // throws, Run still waits for the others and then rethrows the first
+  // exception on the calling thread.
+  template <typename Task>
+  void Run(const Task& task) {
+    RunTask(&Invoke<Task>, &task);
+  }
+
+ private:
+  using TaskFunction = void (*)(const void*, std::size_t);
+
+  template <typename Task>
+  static void Invoke(const void* task, std::size_t index) {
+    (*static_cast<const Task*>(task))(index);
+  }
+
+  void RunTask(TaskFunction function, const void* task);
+  void Work(std::size_t index);
+  // Keeps |error| unless an earlier call of the same Run already failed.
+  void SetError(std::exception_ptr error);
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  TaskFunction function_ = nullptr;
+  const void* task_ = nullptr;
+  std::exception_ptr error_;
+  std::size_t generation_ = 0;
+  std::size_t pending_ = 0;
+  bool stop_ = false;
+};
+
+}  // namespace s21
+
+#endif  // SRC_MODEL_THREAD_POOL_H_
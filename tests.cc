@@ -1,54 +1,92 @@
 #include <gtest/gtest.h>
 
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
+
 #include "model/model.h"
 
+// Every heap allocation made through operator new bumps this counter, so a
+// test can assert that a code path does not allocate.
+static std::atomic<std::size_t> allocations(0);
+
+static void* CountedAlloc(std::size_t size, std::size_t alignment) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  size = (std::max<std::size_t>(size, 1) + alignment - 1) / alignment *
+         alignment;
+  void* p = alignment > alignof(std::max_align_t)
+                ? std::aligned_alloc(alignment, size)
+                : std::malloc(size);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new(std::size_t size) { return CountedAlloc(size, 1); }
+void* operator new[](std::size_t size) { return CountedAlloc(size, 1); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return CountedAlloc(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return CountedAlloc(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
 TEST(s21_graph_network, neuron_1) {
-  s21::Neuron neuron;
   double out = 1;
+  double bias = 0;
+  s21::Neuron neuron(&out, &bias, nullptr, nullptr, 0);
   neuron.SetOutput(out);
   EXPECT_DOUBLE_EQ(neuron.GetOutput(), out);
 }
 
 TEST(s21_graph_network, neuron_2) {
-  s21::Neuron input;
-  s21::Neuron output;
+  std::unique_ptr<s21::Layer> input = std::make_unique<s21::Layer>(1);
+  std::unique_ptr<s21::Layer> output = std::make_unique<s21::Layer>(1, input);
   double in = 1;
-  input.SetOutput(in);
+  input->SetOutput({in});
 
-  output.AddRandomWeight(&input);
-  EXPECT_TRUE(output.GetConnections().find(&input) !=
-              output.GetConnections().end());
-  output.CalcOutput();
-  double expected_output = s21::utility::ActivationFunc(
-      output.GetConnections().at(&input) * input.GetOutput());
-  EXPECT_DOUBLE_EQ(output.GetOutput(), expected_output);
+  s21::Neuron neuron = output->Neurons()[0];
+  EXPECT_EQ(neuron.GetNumberOfWeights(), 1u);
+  neuron.CalcOutput();
+  double expected_output =
+      s21::utility::ActivationFunc(neuron.GetWeight(0) * in);
+  EXPECT_DOUBLE_EQ(neuron.GetOutput(), expected_output);
 }
 
 TEST(s21_graph_network, neuron_3) {
-  s21::Neuron input_1, input_2, input_3, input_4;
-  s21::Neuron output;
-  double in_1 = 1;
-  double in_2 = -1;
-  double in_3 = 0.5;
-  double in_4 = -0.7;
-  input_1.SetOutput(in_1);
-  input_2.SetOutput(in_2);
-  input_3.SetOutput(in_3);
-  input_4.SetOutput(in_4);
-
-  output.AddRandomWeight(&input_1);
-  output.AddRandomWeight(&input_2);
-  output.AddRandomWeight(&input_3);
-  output.AddRandomWeight(&input_4);
-
-  output.CalcOutput();
-  std::map<s21::Neuron*, double> connections = output.GetConnections();
+  std::vector<double> in({1, -1, 0.5, -0.7});
+  std::unique_ptr<s21::Layer> input = std::make_unique<s21::Layer>(in.size());
+  std::unique_ptr<s21::Layer> output = std::make_unique<s21::Layer>(2, input);
+  input->SetOutput(in);
+
+  // Neuron-by-neuron and whole-layer passes agree
+  s21::Neuron neuron = output->Neurons()[1];
+  neuron.CalcOutput();
   double expected_output = s21::utility::ActivationFunc(
-      connections.at(&input_1) * input_1.GetOutput() +
-      connections.at(&input_2) * input_2.GetOutput() +
-      connections.at(&input_3) * input_3.GetOutput() +
-      connections.at(&input_4) * input_4.GetOutput());
-  EXPECT_DOUBLE_EQ(output.GetOutput(), expected_output);
+      neuron.GetWeight(0) * in[0] + neuron.GetWeight(1) * in[1] +
+      neuron.GetWeight(2) * in[2] + neuron.GetWeight(3) * in[3]);
+  EXPECT_DOUBLE_EQ(neuron.GetOutput(), expected_output);
+
+  neuron.SetWeight(2, 0.25);
+  EXPECT_EQ(output->Weights()[in.size() + 2], 0.25);
+  output->CalculateOutput();
+  EXPECT_NEAR(output->Outputs()[1],
+              s21::utility::ActivationFunc(
+                  neuron.GetWeight(0) * in[0] + neuron.GetWeight(1) * in[1] +
+                  0.25 * in[2] + neuron.GetWeight(3) * in[3]),
+              1e-14);
 }
 
 TEST(s21_graph_network, layer_constructor) {
@@ -146,6 +184,1067 @@ TEST(s21_matrix_network, mn_forward_and_back_propagation) {
   EXPECT_TRUE(mn.GetOutput()[0] > exp_result);
 }
 
+TEST(s21_matrix, contiguous_storage) {
+  s21::Matrix m(2, 3);
+  for (size_t i = 0; i < m.GetSize(); i++) m.Data()[i] = (double)i;
+
+  EXPECT_EQ(m.GetStride(), 3u);
+  EXPECT_DOUBLE_EQ(m(1, 2), 5);
+
+  m.SetColumns(2);
+  EXPECT_DOUBLE_EQ(m(1, 0), 3);
+  EXPECT_DOUBLE_EQ(m(1, 1), 4);
+
+  m.SetRows(3);
+  EXPECT_DOUBLE_EQ(m(1, 1), 4);
+  EXPECT_DOUBLE_EQ(m(2, 1), 0);
+
+  s21::Matrix copy(m);
+  EXPECT_TRUE(copy == m);
+  EXPECT_NE(copy.Data(), m.Data());
+}
+
+TEST(s21_matrix, blocked_gemm) {
+  // Odd sizes exercise the partial micro-tiles and panels.
+  s21::Matrix a(37, 300), b(300, 45);
+  for (size_t i = 0; i < a.GetSize(); i++) a.Data()[i] = (double)(i % 13) - 6;
+  for (size_t i = 0; i < b.GetSize(); i++) b.Data()[i] = (double)(i % 7) / 3;
+
+  s21::Matrix expected(a.GetRows(), b.GetColumns());
+  for (size_t i = 0; i < a.GetRows(); i++)
+    for (size_t j = 0; j < b.GetColumns(); j++)
+      for (size_t k = 0; k < a.GetColumns(); k++)
+        expected(i, j) += a(i, k) * b(k, j);
+
+  EXPECT_TRUE(a * b == expected);
+
+  s21::Matrix c(b.GetColumns(), a.GetRows());
+  s21::kernels::Gemm(s21::kernels::Transpose::kYes,
+                     s21::kernels::Transpose::kYes, b.GetColumns(),
+                     a.GetRows(), b.GetRows(), 1, b.Data(), b.GetStride(),
+                     a.Data(), a.GetStride(), 0, c.Data(), c.GetStride());
+  EXPECT_TRUE(c == expected.Transpose());
+}
+
+TEST(s21_matrix, gemv_and_ger) {
+  s21::Matrix a(3, 5), x(5, 1), z(3, 1), y;
+  for (size_t i = 0; i < a.GetSize(); i++) a.Data()[i] = (double)i / 4 - 1;
+  for (size_t i = 0; i < x.GetSize(); i++) x.Data()[i] = (double)i - 2;
+  for (size_t i = 0; i < z.GetSize(); i++) z.Data()[i] = (double)i + 0.5;
+
+  a.Gemv(x, &y);
+  EXPECT_TRUE(y == a * x);
+
+  a.GemvTransposed(z, &y);
+  EXPECT_TRUE(y == a.Transpose() * z);
+
+  s21::Matrix expected = a - 0.3 * z * x.Transpose();
+  a.Ger(-0.3, z, x);
+  EXPECT_TRUE(a == expected);
+
+  EXPECT_THROW(a.Gemv(z, &y), std::logic_error);
+}
+
+TEST(s21_matrix, simd_kernels) {
+  using s21::kernels::InstructionSet;
+  const size_t n = 37;  // not a multiple of any vector width
+  std::vector<double> x(n), y(n), a(5 * n);
+  for (size_t i = 0; i < n; i++) {
+    x[i] = (double)i / 3 - 6;
+    y[i] = std::sin((double)i);
+  }
+  for (size_t i = 0; i < a.size(); i++) a[i] = std::cos((double)i);
+
+  const InstructionSet detected = s21::kernels::DetectInstructionSet();
+  for (int set = 0; set <= (int)detected; set++) {
+    s21::kernels::SetInstructionSet((InstructionSet)set);
+
+    double dot = 0;
+    for (size_t i = 0; i < n; i++) dot += x[i] * y[i];
+    EXPECT_NEAR(s21::kernels::Dot(n, x.data(), y.data()), dot, 1e-12);
+
+    std::vector<double> gemv(5);
+    s21::kernels::Gemv(5, n, a.data(), n, x.data(), gemv.data());
+    for (size_t r = 0; r < 5; r++)
+      EXPECT_NEAR(gemv[r], s21::kernels::Dot(n, a.data() + r * n, x.data()),
+                  1e-12);
+
+    std::vector<std::uint8_t> bytes(n);
+    for (size_t i = 0; i < n; i++) bytes[i] = (std::uint8_t)(i * 7 + 200);
+    std::vector<double> scaled(n);
+    s21::kernels::ScaleBytes(n, 0.5, bytes.data(), scaled.data());
+    for (size_t i = 0; i < n; i++) EXPECT_EQ(scaled[i], 0.5 * bytes[i]);
+
+    std::vector<double> axpy(y), mul(y), sigmoid(n), derivative(y);
+    s21::kernels::Axpy(n, 0.5, x.data(), axpy.data());
+    s21::kernels::Mul(n, x.data(), mul.data());
+    s21::kernels::Sigmoid(n, x.data(), sigmoid.data());
+    s21::kernels::MulSigmoidDerivative(n, sigmoid.data(), derivative.data());
+    for (size_t i = 0; i < n; i++) {
+      double expected = s21::utility::ActivationFunc(x[i]);
+      EXPECT_NEAR(axpy[i], y[i] + 0.5 * x[i], 1e-15);
+      EXPECT_DOUBLE_EQ(mul[i], y[i] * x[i]);
+      EXPECT_NEAR(sigmoid[i], expected, 1e-14 * expected);
+      EXPECT_NEAR(derivative[i], y[i] * expected * (1 - expected), 1e-14);
+    }
+
+    // Single precision against the double results
+    std::vector<float> xf(x.begin(), x.end()), yf(y.begin(), y.end());
+    std::vector<float> af(a.begin(), a.end()), gemvf(5), scaledf(n);
+    std::vector<float> axpyf(yf), sigmoidf(n), derivativef(yf);
+    EXPECT_NEAR(s21::kernels::Dot(n, xf.data(), yf.data()), dot, 1e-4);
+    s21::kernels::Gemv(5, n, af.data(), n, xf.data(), gemvf.data());
+    s21::kernels::ScaleBytes(n, 0.5f, bytes.data(), scaledf.data());
+    s21::kernels::Axpy(n, 0.5f, xf.data(), axpyf.data());
+    s21::kernels::Sigmoid(n, xf.data(), sigmoidf.data());
+    s21::kernels::MulSigmoidDerivative(n, sigmoidf.data(), derivativef.data());
+    for (size_t r = 0; r < 5; r++) EXPECT_NEAR(gemvf[r], gemv[r], 1e-4);
+    for (size_t i = 0; i < n; i++) {
+      EXPECT_EQ(scaledf[i], (float)scaled[i]);
+      EXPECT_NEAR(axpyf[i], axpy[i], 1e-5);
+      EXPECT_NEAR(sigmoidf[i], sigmoid[i], 1e-6);
+      EXPECT_NEAR(derivativef[i], derivative[i], 1e-6);
+    }
+
+    // 8-bit GEMV is exact; 150 columns cover full and partial vectors
+    const size_t rows = 6, columns = 150;
+    std::vector<std::int8_t> a8(rows * columns);
+    std::vector<std::uint8_t> x8(columns);
+    for (size_t i = 0; i < a8.size(); i++) a8[i] = (std::int8_t)(i * 37 % 255);
+    for (size_t i = 0; i < columns; i++) x8[i] = (std::uint8_t)(i * 13 % 128);
+    std::vector<std::int32_t> gemv8(rows);
+    s21::kernels::GemvS8(rows, columns, a8.data(), columns, x8.data(),
+                         gemv8.data());
+    for (size_t r = 0; r < rows; r++) {
+      std::int32_t expected = 0;
+      for (size_t c = 0; c < columns; c++)
+        expected += a8[r * columns + c] * x8[c];
+      EXPECT_EQ(gemv8[r], expected);
+    }
+  }
+  s21::kernels::SetInstructionSet(detected);
+}
+
+TEST(s21_utility, seeded_random_weights) {
+  std::vector<double> a(1000), b(1000);
+  s21::utility::SeedRandom(42);
+  s21::utility::FillRandom(a.data(), a.size());
+  s21::utility::SeedRandom(42);
+  s21::utility::FillRandom(b.data(), b.size());
+  EXPECT_EQ(a, b);
+  double sum = 0;
+  for (double w : a) {
+    EXPECT_GE(w, -1);
+    EXPECT_LT(w, 1);
+    sum += w;
+  }
+  EXPECT_LT(std::abs(sum) / 1000, 0.1);
+  s21::utility::SeedRandom(43);
+  s21::utility::FillRandom(b.data(), b.size());
+  EXPECT_NE(a, b);
+
+  // Networks built after the same seed start from the same weights
+  for (auto type : {s21::NetworkType::kMatrix, s21::NetworkType::kGraph}) {
+    s21::utility::SeedRandom(7);
+    s21::NeuralNetwork first(type, s21::NetworkSettings());
+    s21::utility::SeedRandom(7);
+    s21::NeuralNetwork second(type, s21::NetworkSettings());
+    EXPECT_EQ(first.GetWeights(), second.GetWeights());
+  }
+}
+
+TEST(s21_matrix_network, mn_train_batch) {
+  s21::NetworkSettings settings;
+  settings.neurons_in_input_layer = 2;
+  settings.neurons_in_hidden_layer = 3;
+  settings.neurons_in_output_layer = 1;
+  settings.number_of_hidden_layers = 1;
+
+  std::vector<double> weights({0.5, 0.3, 0.2, 0.1, 0.6, 0.4, 0.2, 0.3, 0.4});
+  std::vector<double> input({1, 0.5}), expected({1});
+
+  s21::MatrixNetwork single(settings), batch(settings);
+  single.LoadWeights(weights);
+  batch.LoadWeights(weights);
+
+  // The averaged gradient of identical samples is the gradient of one sample
+  single.TrainBatch({&input}, {&expected}, 0.3);
+  batch.TrainBatch({&input, &input, &input}, {&expected, &expected, &expected},
+                   0.3);
+
+  std::vector<double> single_weights = single.GetWeights();
+  std::vector<double> batch_weights = batch.GetWeights();
+  for (size_t i = 0; i < weights.size(); i++)
+    EXPECT_NEAR(single_weights[i], batch_weights[i], 1e-12);
+
+  batch.SetInput(input);
+  batch.ForwardPropagation();
+  EXPECT_TRUE(batch.GetOutput()[0] > 0.64015681610605701);
+}
+
+TEST(s21_matrix_network, mn_train_batch_parallel) {
+  s21::NetworkSettings settings;
+  settings.neurons_in_input_layer = 4;
+  settings.neurons_in_hidden_layer = 5;
+  settings.neurons_in_output_layer = 3;
+  settings.number_of_hidden_layers = 2;
+
+  std::vector<std::vector<double>> inputs, expected;
+  for (int i = 0; i < 7; i++) {
+    inputs.push_back({0.1 * i, 1 - 0.1 * i, 0.5, 0.05 * i * i});
+    expected.push_back({0, 0, 0});
+    expected.back()[static_cast<size_t>(i % 3)] = 1;
+  }
+  std::vector<const std::vector<double>*> input_ptrs, expected_ptrs;
+  for (size_t i = 0; i < inputs.size(); i++) {
+    input_ptrs.push_back(&inputs[i]);
+    expected_ptrs.push_back(&expected[i]);
+  }
+
+  s21::MatrixNetwork serial(settings);
+  std::vector<double> weights = serial.GetWeights();
+  std::vector<std::vector<double>> results;
+  for (size_t threads : {3, 3, 4}) {
+    s21::MatrixNetwork parallel(settings);
+    parallel.LoadWeights(weights);
+    parallel.SetThreads(threads);
+    for (int step = 0; step < 3; step++)
+      parallel.TrainBatch(input_ptrs, expected_ptrs, 0.5);
+    results.push_back(parallel.GetWeights());
+  }
+  for (int step = 0; step < 3; step++)
+    serial.TrainBatch(input_ptrs, expected_ptrs, 0.5);
+  std::vector<double> serial_weights = serial.GetWeights();
+
+  // Bitwise equal for the same thread count, equal up to rounding otherwise
+  EXPECT_EQ(results[0], results[1]);
+  for (size_t i = 0; i < weights.size(); i++) {
+    EXPECT_NEAR(results[0][i], serial_weights[i], 1e-12);
+    EXPECT_NEAR(results[2][i], serial_weights[i], 1e-12);
+  }
+}
+
+TEST(s21_matrix_network, mn_train_hogwild) {
+  s21::NetworkSettings settings;
+  settings.neurons_in_input_layer = 2;
+  settings.neurons_in_hidden_layer = 3;
+  settings.neurons_in_output_layer = 1;
+  settings.number_of_hidden_layers = 1;
+
+  std::vector<double> weights({0.5, 0.3, 0.2, 0.1, 0.6, 0.4, 0.2, 0.3, 0.4});
+  std::vector<double> input({1, 0.5}), expected({1});
+
+  s21::MatrixNetwork serial(settings), hogwild(settings);
+  serial.LoadWeights(weights);
+  hogwild.LoadWeights(weights);
+  EXPECT_EQ(hogwild.PrepareWorkers(3), 3u);
+
+  // A worker step is a plain SGD step, whichever worker state it runs on
+  serial.SetInput(input);
+  serial.ForwardPropagation();
+  serial.BackPropagation(expected, 0.3);
+  hogwild.TrainSample(2, input, expected, 0.3);
+  EXPECT_EQ(serial.GetWeights(), hogwild.GetWeights());
+
+  s21::ThreadPool pool(3);
+  pool.Run([&](size_t worker) {
+    for (int i = 0; i < 100; i++)
+      hogwild.TrainSample(worker, input, expected, 0.3);
+  });
+  hogwild.SetInput(input);
+  hogwild.ForwardPropagation();
+  EXPECT_GT(hogwild.GetOutput()[0], 0.9);
+
+  // A task that throws on another thread fails Run, not the process
+  std::atomic<size_t> finished(0);
+  auto failing = [&](size_t worker) {
+    if (worker == 2) throw std::runtime_error("worker");
+    finished++;
+  };
+  EXPECT_THROW(pool.Run(failing), std::runtime_error);
+  EXPECT_EQ(finished.load(), 2u);
+  pool.Run([&](size_t) { finished++; });
+  EXPECT_EQ(finished.load(), 5u);
+}
+
+TEST(s21_neural_network, copy_output) {
+  s21::NetworkSettings settings;
+  settings.neurons_in_input_layer = 3;
+  settings.neurons_in_hidden_layer = 4;
+  settings.neurons_in_output_layer = 2;
+  settings.number_of_hidden_layers = 2;
+
+  s21::MatrixNetwork mn(settings);
+  s21::GraphNetwork gn(settings);
+  for (s21::NetworkInterface* network :
+       std::vector<s21::NetworkInterface*>{&mn, &gn}) {
+    network->SetInput({0.1, 0.2, 0.3});
+    network->ForwardPropagation();
+    std::vector<double> output(settings.neurons_in_output_layer);
+    network->CopyOutput(output.data());
+    EXPECT_EQ(output, network->GetOutput());
+  }
+}
+
+TEST(s21_neural_network, steady_state_epoch_does_not_allocate) {
+  const std::string filename = "/tmp/s21_tests_allocations.csv";
+  {
+    std::ofstream file(filename);
+    for (int i = 0; i < 30; i++)
+      file << i % 3 + 1 << ',' << i * 8 << ',' << 255 - i * 8 << ",12,"
+           << (i % 3) * 100 << '\n';
+  }
+  std::size_t before = allocations.load();
+  s21::Dataset data = s21::CsvReader().Read(filename);
+  std::remove(filename.c_str());
+  EXPECT_GT(allocations.load(), before);
+
+  s21::NetworkSettings settings;
+  settings.neurons_in_input_layer = 4;
+  settings.neurons_in_hidden_layer = 6;
+  settings.neurons_in_output_layer = 3;
+  settings.number_of_hidden_layers = 2;
+
+  using s21::NetworkType;
+  using s21::TrainMode;
+  struct Setup {
+    NetworkType type;
+    std::size_t batch_size;
+    std::size_t threads;
+    TrainMode mode;
+  };
+  const TrainMode kSync = TrainMode::kSynchronous;
+  const std::vector<Setup> setups = {{NetworkType::kMatrix, 1, 1, kSync},
+                                     {NetworkType::kMatrix, 4, 1, kSync},
+                                     {NetworkType::kMatrix, 4, 2, kSync},
+                                     {NetworkType::kMatrix, 1, 2,
+                                      TrainMode::kHogwild},
+                                     {NetworkType::kGraph, 1, 1, kSync}};
+  for (const Setup& setup : setups) {
+    s21::NeuralNetwork network(setup.type, settings);
+    network.SetBatchSize(setup.batch_size);
+    network.SetThreads(setup.threads);
+    network.SetTrainMode(setup.mode);
+    network.Train(data, 1);
+    network.Test(data, 1);
+
+    before = allocations.load();
+    network.Train(data, 2);
+    EXPECT_EQ(allocations.load() - before, 0u);
+
+    // Test only allocates the per-class vectors of its result
+    before = allocations.load();
+    s21::NetworkTestMetrics metrics = network.Test(data, 1);
+    EXPECT_LE(allocations.load() - before, 5u);
+  }
+}
+
+TEST(s21_neural_network, batched_test) {
+  std::vector<std::uint8_t> pixels(150 * 4), labels(150);
+  for (std::size_t i = 0; i < pixels.size(); i++) {
+    pixels[i] = (std::uint8_t)(i * 37 % 256);
+  }
+  for (std::size_t i = 0; i < labels.size(); i++) {
+    labels[i] = (std::uint8_t)(i % 3 + 1);
+  }
+  s21::Dataset data(4, pixels, labels);
+
+  s21::NetworkSettings settings;
+  settings.neurons_in_input_layer = 4;
+  settings.neurons_in_hidden_layer = 5;
+  settings.neurons_in_output_layer = 3;
+  settings.number_of_hidden_layers = 2;
+  for (auto type : {s21::NetworkType::kMatrix, s21::NetworkType::kGraph}) {
+    s21::NeuralNetwork network(type, settings);
+    network.Train(data, 1, 0.5);
+    std::size_t correct = 0;
+    for (s21::ImageView image : data) {
+      correct += (int)network.Predict(image).first == image.GetNumber() - 1;
+    }
+
+    for (std::size_t threads : {1, 3}) {
+      network.SetThreads(threads);
+      std::vector<std::size_t> progress;
+      s21::NetworkTestMetrics metrics = network.Test(
+          data, 1, nullptr, [&](std::size_t p) { progress.push_back(p); });
+      EXPECT_DOUBLE_EQ(metrics.accuracy, (double)correct / 150);
+      ASSERT_FALSE(progress.empty());
+      EXPECT_EQ(progress.back(), 100u);
+      for (std::size_t i = 1; i < progress.size(); i++) {
+        EXPECT_LT(progress[i - 1], progress[i]);
+      }
+
+      ASSERT_EQ(metrics.classes, 3u);
+      ASSERT_EQ(metrics.confusion.size(), 9u);
+      std::size_t diagonal = 0;
+      for (std::size_t c = 0; c < 3; c++) {
+        std::size_t row = 0;
+        for (std::size_t p = 0; p < 3; p++) row += metrics.confusion[c * 3 + p];
+        EXPECT_EQ(row, 50u);
+        diagonal += metrics.confusion[c * 3 + c];
+        EXPECT_DOUBLE_EQ(metrics.class_recall[c],
+                         (double)metrics.confusion[c * 3 + c] / 50);
+      }
+      EXPECT_EQ(diagonal, correct);
+      ASSERT_EQ(metrics.top_k_accuracy.size(), 5u);
+      EXPECT_DOUBLE_EQ(metrics.top_k_accuracy[0], metrics.accuracy);
+      EXPECT_LE(metrics.top_k_accuracy[0], metrics.top_k_accuracy[1]);
+      EXPECT_DOUBLE_EQ(metrics.top_k_accuracy[2], 1);
+
+      s21::Dataset wide(5, std::vector<std::uint8_t>(5 * 150), labels);
+      EXPECT_THROW(network.Test(wide, 1), std::runtime_error);
+    }
+  }
+}
+
+TEST(s21_neural_network, infer_does_not_allocate) {
+  s21::NetworkSettings settings;
+  settings.neurons_in_input_layer = 64;
+  settings.neurons_in_hidden_layer = 20;
+  settings.neurons_in_output_layer = 5;
+  settings.number_of_hidden_layers = 2;
+  std::vector<std::uint8_t> pixels(settings.neurons_in_input_layer * 3);
+  for (size_t i = 0; i < pixels.size(); i++)
+    pixels[i] = (std::uint8_t)(i * 11 % 256);
+  s21::Dataset data(settings.neurons_in_input_layer, pixels, {1, 2, 3});
+
+  s21::NeuralNetwork source(s21::NetworkType::kMatrix, settings);
+  const std::string v2 = "/tmp/s21_infer_test.bin";
+  const std::string int8 = "/tmp/s21_infer_test_int8.bin";
+  s21::WeightWriter::Write(v2, source.GetWeights(), settings);
+  s21::QuantizedNetwork::Quantize(source.GetWeights(), settings, data, 3)
+      .Save(int8);
+
+  std::vector<std::unique_ptr<s21::NeuralNetwork>> networks;
+  for (auto type : {s21::NetworkType::kMatrix, s21::NetworkType::kGraph}) {
+    for (auto precision : {s21::Precision::kDouble, s21::Precision::kFloat}) {
+      networks.push_back(
+          std::make_unique<s21::NeuralNetwork>(type, settings, precision));
+      networks.back()->SetWeights(source.GetWeights());
+    }
+  }
+  networks.push_back(std::make_unique<s21::NeuralNetwork>(
+      std::make_shared<s21::WeightFile>(v2)));
+  networks.push_back(std::make_unique<s21::NeuralNetwork>(
+      std::make_shared<s21::WeightFile>(int8)));
+
+  std::vector<double> expected;
+  for (size_t i = 0; i < data.size(); i++)
+    expected.push_back(source.Predict(data[i]).second);
+
+  std::vector<double> results(data.size());
+  for (auto& network : networks) {
+    network->Infer(data[0].Pixels(), data[0].GetSize());
+    std::size_t before = allocations.load();
+    for (size_t i = 0; i < data.size(); i++) {
+      results[i] = network->Infer(data[i].Pixels(), data[i].GetSize()).second;
+    }
+    EXPECT_EQ(allocations.load() - before, 0u);
+    // Confidences, since int8 may break a near tie differently
+    for (size_t i = 0; i < data.size(); i++)
+      EXPECT_NEAR(results[i], expected[i], 0.02);
+    EXPECT_THROW(network->Infer(pixels.data(), 3), std::runtime_error);
+  }
+
+  // Infer leaves the activations of a training pass alone
+  std::vector<std::unique_ptr<s21::NetworkInterface>> backends;
+  backends.push_back(std::make_unique<s21::MatrixNetwork>(settings));
+  backends.push_back(std::make_unique<s21::GraphNetwork>(settings));
+  backends.push_back(std::make_unique<s21::BasicGraphNetwork<float>>(settings));
+  std::vector<double> scratch(settings.neurons_in_output_layer);
+  for (auto& backend : backends) {
+    backend->SetScaledInput(data[0].Pixels(), 1 / s21::Image::kMaxValue);
+    backend->ForwardPropagation();
+    std::vector<double> output = backend->GetOutput();
+    backend->Infer(data[1].Pixels(), 1 / s21::Image::kMaxValue,
+                   scratch.data());
+    EXPECT_EQ(backend->GetOutput(), output);
+  }
+  std::remove(v2.c_str());
+  std::remove(int8.c_str());
+}
+
+TEST(s21_neural_network, float_precision) {
+  s21::NetworkSettings settings;
+  settings.neurons_in_input_layer = 50;
+  settings.neurons_in_hidden_layer = 40;
+  settings.neurons_in_output_layer = 5;
+  settings.number_of_hidden_layers = 2;
+  std::vector<std::uint8_t> pixels(settings.neurons_in_input_layer);
+  for (size_t i = 0; i < pixels.size(); i++) pixels[i] = (std::uint8_t)(i * 5);
+  s21::Dataset data(pixels.size(), pixels, {1});
+
+  for (auto type : {s21::NetworkType::kMatrix, s21::NetworkType::kGraph}) {
+    s21::NeuralNetwork dp(type, settings);
+    s21::NeuralNetwork sp(type, settings, s21::Precision::kFloat);
+    EXPECT_EQ(sp.GetPrecision(), s21::Precision::kFloat);
+    // Weights convert on load, so both networks compute the same function
+    sp.SetWeights(dp.GetWeights());
+    std::vector<double> weights = sp.GetWeights();
+    for (size_t i = 0; i < weights.size(); i++)
+      EXPECT_EQ(weights[i], (double)(float)dp.GetWeights()[i]);
+
+    auto dp_prediction = dp.Predict(data[0]);
+    auto sp_prediction = sp.Predict(data[0]);
+    EXPECT_EQ(dp_prediction.first, sp_prediction.first);
+    EXPECT_NEAR(dp_prediction.second, sp_prediction.second, 1e-5);
+  }
+
+  // Float training converges like the double one
+  s21::NetworkSettings small;
+  small.neurons_in_input_layer = 2;
+  small.neurons_in_hidden_layer = 3;
+  small.neurons_in_output_layer = 1;
+  small.number_of_hidden_layers = 1;
+  std::vector<double> in({1, 0.5}), expected({1});
+  s21::BasicMatrixNetwork<float> mn(small);
+  s21::BasicGraphNetwork<float> gn(small);
+  for (s21::NetworkInterface* network :
+       std::vector<s21::NetworkInterface*>{&mn, &gn}) {
+    network->SetInput(in);
+    network->ForwardPropagation();
+    const double before = network->GetOutput()[0];
+    for (int i = 0; i < 20; i++) {
+      network->TrainBatch({&in, &in}, {&expected, &expected}, 0.5);
+    }
+    network->SetInput(in);
+    network->ForwardPropagation();
+    EXPECT_GT(network->GetOutput()[0], before);
+  }
+}
+
+TEST(s21_weight_file, round_trip_and_version1) {
+  // Version 1 files from the repository still load
+  s21::WeightReader::Data v1 =
+      s21::WeightReader::Read("weights/mlp_l3_e6_a78_2022-09-30_16-42-02.bin");
+  EXPECT_EQ(v1.settings.number_of_hidden_layers, 3u);
+  EXPECT_EQ(v1.epoch, 6u);
+  EXPECT_EQ(v1.accuracy, 78u);
+  EXPECT_EQ(v1.weights.size(), s21::WeightFile::WeightCount(v1.settings));
+
+  const std::string filename = "/tmp/s21_weight_file_test.bin";
+  for (auto dtype : {s21::Precision::kDouble, s21::Precision::kFloat}) {
+    s21::WeightWriter::Write(filename, v1.weights, v1.settings, 7, 81, dtype);
+    s21::WeightReader::Data v2 = s21::WeightReader::Read(filename);
+    EXPECT_EQ(v2.dtype, dtype);
+    EXPECT_EQ(v2.epoch, 7u);
+    EXPECT_EQ(v2.accuracy, 81u);
+    EXPECT_EQ(v2.settings.neurons_in_hidden_layer, 140u);
+    ASSERT_EQ(v2.weights.size(), v1.weights.size());
+    for (size_t i = 0; i < v1.weights.size(); i++) {
+      EXPECT_EQ(v2.weights[i], dtype == s21::Precision::kFloat
+                                   ? (double)(float)v1.weights[i]
+                                   : v1.weights[i]);
+    }
+
+    s21::WeightFile mapped(filename);
+    EXPECT_EQ((std::uintptr_t)mapped.Payload() % 64, 0u);
+  }
+
+  // Concurrent writers use their own temporary files, and none is left
+  {
+    std::thread other([&]() {
+      for (int i = 0; i < 5; i++)
+        s21::WeightWriter::Write(filename, v1.weights, v1.settings, 1, 1);
+    });
+    for (int i = 0; i < 5; i++)
+      s21::WeightWriter::Write(filename, v1.weights, v1.settings, 2, 2);
+    other.join();
+  }
+  EXPECT_EQ(s21::WeightReader::Read(filename).weights, v1.weights);
+  std::size_t siblings = 0;
+  for (const auto& entry : std::filesystem::directory_iterator("/tmp")) {
+    siblings += entry.path().string().rfind(filename, 0) == 0;
+  }
+  EXPECT_EQ(siblings, 1u);
+
+  // A flipped payload byte fails the checksum
+  {
+    std::fstream file(filename, std::ios::in | std::ios::out |
+                                    std::ios::binary);
+    file.seekg(1000);
+    char byte = (char)file.get();
+    file.seekp(1000);
+    file.put((char)~byte);
+  }
+  EXPECT_THROW(s21::WeightReader::Read(filename), std::runtime_error);
+  std::remove(filename.c_str());
+}
+
+TEST(s21_mapped_network, matches_loaded_network) {
+  s21::NetworkSettings settings;
+  settings.neurons_in_input_layer = 30;
+  settings.neurons_in_hidden_layer = 20;
+  settings.neurons_in_output_layer = 4;
+  settings.number_of_hidden_layers = 2;
+  std::vector<std::uint8_t> pixels(settings.neurons_in_input_layer * 6);
+  for (size_t i = 0; i < pixels.size(); i++) pixels[i] = (std::uint8_t)(i * 7);
+  s21::Dataset data(settings.neurons_in_input_layer, pixels,
+                    {1, 2, 3, 4, 1, 2});
+
+  const std::string filename = "/tmp/s21_mapped_network_test.bin";
+  for (auto dtype : {s21::Precision::kDouble, s21::Precision::kFloat}) {
+    s21::NeuralNetwork loaded(s21::NetworkType::kMatrix, settings, dtype);
+    s21::WeightWriter::Write(filename, loaded.GetWeights(), settings, 0, 0,
+                             dtype);
+    s21::NeuralNetwork mapped(std::make_shared<s21::WeightFile>(filename));
+    EXPECT_EQ(mapped.GetPrecision(), dtype);
+    EXPECT_EQ(mapped.GetWeights(), loaded.GetWeights());
+
+    for (size_t i = 0; i < data.size(); i++) {
+      EXPECT_EQ(mapped.Predict(data[i]), loaded.Predict(data[i]));
+    }
+    s21::NetworkTestMetrics expected = loaded.Test(data, 1);
+    s21::NetworkTestMetrics actual = mapped.Test(data, 1);
+    EXPECT_EQ(actual.confusion, expected.confusion);
+
+    EXPECT_THROW(mapped.Train(data, 1), std::runtime_error);
+    EXPECT_THROW(mapped.SetWeights(loaded.GetWeights()), std::runtime_error);
+  }
+  std::remove(filename.c_str());
+}
+
+TEST(s21_quantized_network, close_to_double_network) {
+  s21::NetworkSettings settings;
+  settings.neurons_in_input_layer = 100;
+  settings.neurons_in_hidden_layer = 40;
+  settings.neurons_in_output_layer = 6;
+  settings.number_of_hidden_layers = 2;
+  const size_t count = 20;
+  std::vector<std::uint8_t> pixels(settings.neurons_in_input_layer * count);
+  for (size_t i = 0; i < pixels.size(); i++)
+    pixels[i] = (std::uint8_t)(i * 31 % 256);
+  s21::Dataset data(settings.neurons_in_input_layer, pixels,
+                    std::vector<std::uint8_t>(count, 1));
+  s21::MatrixNetwork network(settings);
+
+  s21::QuantizedNetwork quantized = s21::QuantizedNetwork::Quantize(
+      network.GetWeights(), settings, data, 8);
+  const std::string filename = "/tmp/s21_quantized_network_test.bin";
+  ASSERT_TRUE(quantized.Save(filename));
+  s21::QuantizedNetwork loaded{s21::WeightFile(filename)};
+
+  // Dequantized weights are within half a step of the originals
+  std::vector<double> weights = network.GetWeights();
+  std::vector<double> dequantized = loaded.GetWeights();
+  ASSERT_EQ(dequantized.size(), weights.size());
+  EXPECT_EQ(quantized.GetWeights(), dequantized);
+  EXPECT_EQ(s21::WeightReader::Read(filename).weights, dequantized);
+  double largest = 0;
+  for (double w : weights) largest = std::max(largest, std::fabs(w));
+  for (size_t i = 0; i < weights.size(); i++)
+    EXPECT_NEAR(dequantized[i], weights[i], largest / 254 + 1e-7);
+
+  // Outputs stay close to the double network, and a batch matches the
+  // samples run one by one
+  const size_t outputs = settings.neurons_in_output_layer;
+  std::vector<const std::uint8_t*> inputs;
+  for (size_t i = 0; i < count; i++) inputs.push_back(data[i].Pixels());
+  std::vector<double> batch(count * outputs);
+  loaded.PrepareInference(1, count);
+  loaded.PredictBatch(0, inputs.data(), count, 1 / 255., batch.data());
+  for (size_t i = 0; i < count; i++) {
+    network.SetScaledInput(inputs[i], 1 / 255.);
+    network.ForwardPropagation();
+    loaded.SetScaledInput(inputs[i], 1 / 255.);
+    loaded.ForwardPropagation();
+    std::vector<double> expected = network.GetOutput();
+    std::vector<double> actual = loaded.GetOutput();
+    for (size_t o = 0; o < outputs; o++) {
+      EXPECT_NEAR(actual[o], expected[o], 0.02);
+      EXPECT_EQ(batch[i * outputs + o], actual[o]);
+    }
+  }
+
+  // The file loads as an inference-only NeuralNetwork
+  s21::NeuralNetwork deployed(std::make_shared<s21::WeightFile>(filename));
+  EXPECT_EQ(deployed.GetWeights(), dequantized);
+  EXPECT_THROW(deployed.Train(data, 1), std::runtime_error);
+  std::remove(filename.c_str());
+}
+
+TEST(s21_checkpointer, writes_in_background_and_retains) {
+  s21::NetworkSettings settings;
+  settings.neurons_in_input_layer = 8;
+  settings.neurons_in_hidden_layer = 6;
+  settings.neurons_in_output_layer = 3;
+  settings.number_of_hidden_layers = 1;
+  s21::NeuralNetwork network(s21::NetworkType::kMatrix, settings);
+
+  const std::filesystem::path directory = "/tmp/s21_checkpointer_test";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directory(directory);
+  s21::CheckpointPolicy policy;
+  policy.keep_last = 1;
+  policy.keep_best = 1;
+  std::vector<std::string> files;
+  {
+    s21::Checkpointer checkpointer(policy, directory.string());
+    const std::size_t accuracy[] = {50, 90, 60, 70};
+    for (std::size_t epoch = 1; epoch <= 4; epoch++) {
+      checkpointer.Save(network, epoch, accuracy[epoch - 1]);
+    }
+    checkpointer.Flush();
+    files = checkpointer.GetFiles();
+  }
+
+  // The most accurate checkpoint and the last one are kept, nothing else
+  ASSERT_EQ(files.size(), 2u);
+  std::vector<std::size_t> epochs;
+  for (const std::string& file : files) {
+    s21::WeightReader::Data data = s21::WeightReader::Read(file);
+    EXPECT_EQ(data.weights, network.GetWeights());
+    epochs.push_back(data.epoch);
+  }
+  EXPECT_EQ(epochs, std::vector<std::size_t>({2, 4}));
+  const auto entries = std::filesystem::directory_iterator(directory);
+  EXPECT_EQ(std::distance(begin(entries), end(entries)), 2);
+  std::filesystem::remove_all(directory);
+
+  // Training keeps every epoch file unless a policy is configured
+  s21::Configuration configuration;
+  EXPECT_EQ(configuration.GetCheckpointKeepLast(), 0u);
+  EXPECT_EQ(configuration.GetCheckpointKeepBest(), 0u);
+}
+
+TEST(s21_csv_reader, read) {
+  const std::string filename = "/tmp/s21_tests_reader.csv";
+  {
+    std::ofstream file(filename);
+    file << "3,0,255,12,7\n"
+         << "26,1,2,254,0\r\n"
+         << "1,009,4,0,1";
+  }
+  s21::Dataset images = s21::CsvReader().Read(filename);
+  ASSERT_EQ(images.size(), 3u);
+  EXPECT_EQ(images.GetImageSize(), 4u);
+  const std::vector<std::vector<std::uint8_t>> expected = {
+      {0, 255, 12, 7}, {1, 2, 254, 0}, {9, 4, 0, 1}};
+  const std::vector<int> numbers = {3, 26, 1};
+  for (std::size_t i = 0; i < images.size(); i++) {
+    s21::ImageView image = images[i];
+    EXPECT_EQ(image.GetNumber(), numbers[i]);
+    EXPECT_EQ(std::vector<std::uint8_t>(image.Pixels(),
+                                        image.Pixels() + image.GetSize()),
+              expected[i]);
+  }
+
+  for (const char* line :
+       {"1,2,x3\n", "1,2 3\n", "a,1\n", "1,2\n\n", "1,0.5\n", "1,-2\n",
+        "1,256\n", "1,1e2\n", "1,2,3\n1,2\n", "0,1\n", "27,1\n",
+        "1,2\n255,3\n", "3,0,12,\n", "1,2,\n2,3,\n", "1,2\n2,3,\n"}) {
+    std::ofstream(filename) << line;
+    try {
+      s21::CsvReader().Read(filename);
+      ADD_FAILURE() << line;
+    } catch (const std::runtime_error& e) {
+      EXPECT_STREQ(e.what(), "некорректный формат данных");
+    }
+  }
+  std::remove(filename.c_str());
+  EXPECT_THROW(s21::CsvReader().Read(filename), std::runtime_error);
+}
+
+TEST(s21_csv_reader, parallel_read) {
+  const std::string filename = "/tmp/s21_tests_parallel_reader.csv";
+  {
+    std::ofstream file(filename);
+    for (int row = 0; row < 1500; row++) {
+      file << row % 26 + 1;
+      for (int i = 0; i < s21::Image::kSizeInPx; i++)
+        file << ',' << (row * 31 + i * 7) % 256;
+      file << '\n';
+    }
+  }
+
+  // Chunked parsing gives the same images in the same order
+  s21::Dataset serial = s21::CsvReader(1).Read(filename);
+  s21::CsvReader reader(4);
+  ASSERT_EQ(serial.size(), 1500u);
+  // The reader keeps its threads between reads and rebuilds them when the
+  // thread count changes
+  for (std::size_t threads : {4, 4, 3}) {
+    reader.SetThreads(threads);
+    s21::Dataset parallel = reader.Read(filename);
+    ASSERT_EQ(parallel.size(), serial.size());
+    const std::size_t bytes = serial.size() * serial.GetImageSize();
+    EXPECT_TRUE(std::equal(serial.Pixels(), serial.Pixels() + bytes,
+                           parallel.Pixels()));
+    EXPECT_TRUE(std::equal(serial.Labels(), serial.Labels() + serial.size(),
+                           parallel.Labels()));
+  }
+
+  std::ofstream(filename, std::ios::app) << "5,1,two\n";
+  EXPECT_THROW(reader.Read(filename), std::runtime_error);
+  std::remove(filename.c_str());
+}
+
+TEST(s21_csv_reader, dataset_cache) {
+  const std::string filename = "/tmp/s21_tests_cache.csv";
+  const std::string cache = s21::DatasetCache::CachePath(filename);
+  std::remove(cache.c_str());
+  std::ofstream(filename) << "3,0,255,12\n26,1,2,3\n";
+
+  s21::CsvReader reader(1, true);
+  s21::Dataset parsed = reader.Read(filename);
+  std::unique_ptr<s21::DatasetCache> mapped = s21::DatasetCache::Open(filename);
+  ASSERT_TRUE(mapped);
+  EXPECT_EQ(mapped->GetCount(), 2u);
+  EXPECT_EQ(mapped->GetImageSize(), 3u);
+  EXPECT_EQ(mapped->Pixels()[1], 255);
+  EXPECT_EQ(mapped->Labels()[1], 26);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(mapped->Pixels()) % 64, 0u);
+
+  // The header is little-endian whatever the host, and no temporary file
+  // is left behind
+  {
+    std::ifstream file(cache, std::ios::binary);
+    std::vector<char> header(64);
+    file.read(header.data(), 64);
+    EXPECT_EQ(header[16], 2);
+    EXPECT_EQ(header[24], 3);
+    EXPECT_EQ(std::count(header.begin() + 17, header.begin() + 24, 0), 7);
+  }
+  std::size_t siblings = 0;
+  for (const auto& entry : std::filesystem::directory_iterator("/tmp")) {
+    siblings += entry.path().string().rfind(cache, 0) == 0;
+  }
+  EXPECT_EQ(siblings, 1u);
+
+  // A cached dataset points straight into the mapped file
+  s21::Dataset cached = reader.Read(filename);
+  ASSERT_EQ(cached.size(), parsed.size());
+  EXPECT_TRUE(std::equal(parsed.Pixels(), parsed.Pixels() + 6,
+                         cached.Pixels()));
+  EXPECT_EQ(cached[1].GetNumber(), 26);
+  EXPECT_THROW(s21::CsvReader(1, true, 3).Read(filename), std::runtime_error);
+
+  // A changed source invalidates the cache and is cached again on read
+  std::ofstream(filename) << "3,0,255,12\n26,1,2,4\n";
+  EXPECT_FALSE(s21::DatasetCache::Open(filename));
+  EXPECT_EQ(reader.Read(filename)[1].Pixels()[2], 4);
+  EXPECT_TRUE(s21::DatasetCache::Open(filename));
+
+  std::remove(filename.c_str());
+  std::remove(cache.c_str());
+}
+
+TEST(s21_model, parallel_cross_validation) {
+  const std::string filename = "/tmp/s21_tests_cross_validation.csv";
+  {
+    std::ofstream file(filename);
+    for (int row = 0; row < 60; row++) {
+      file << row % 3 + 1;
+      for (int i = 0; i < s21::Image::kSizeInPx; i++)
+        file << ',' << (i % 3 == row % 3 ? 255 : 0);
+      file << '\n';
+    }
+  }
+  s21::Model model;
+  std::promise<void> loaded;
+  model.SetTrainDataset(filename,
+                        [&](std::string, std::size_t) { loaded.set_value(); });
+  loaded.get_future().wait();
+  std::remove(filename.c_str());
+  std::remove(s21::DatasetCache::CachePath(filename).c_str());
+
+  s21::Configuration configuration;
+  configuration.SetSeed(5);
+  configuration.SetNumberOfHiddenLayers(2);
+  model.SetConfiguration(configuration);
+
+  auto run = [&model]() {
+    std::promise<s21::CrossValidationMetrics> summary;
+    std::promise<s21::NetworkTestMetrics> best;
+    model.TrainCrossValidation(
+        1, 4, nullptr, nullptr,
+        [&](s21::NetworkTestMetrics m) { best.set_value(m); },
+        [&](const s21::CrossValidationMetrics& m) { summary.set_value(m); });
+    return std::make_pair(summary.get_future().get(), best.get_future().get());
+  };
+  auto [summary, best] = run();
+  ASSERT_EQ(summary.folds.size(), 4u);
+  EXPECT_EQ(best.fscore, summary.folds[summary.best_fold].fscore);
+  double mean = 0;
+  for (const s21::NetworkTestMetrics& fold : summary.folds) {
+    EXPECT_FALSE(fold.fscore > best.fscore);
+    mean += fold.accuracy / 4;
+  }
+  EXPECT_DOUBLE_EQ(summary.mean.accuracy, mean);
+  EXPECT_GE(summary.stddev.accuracy, 0);
+  EXPECT_TRUE(model.IsNetworkCreated());
+
+  // Every fold is seeded on its own, so a rerun gives the same folds
+  auto [again, best_again] = run();
+  for (std::size_t i = 0; i < 4; i++) {
+    EXPECT_EQ(again.folds[i].accuracy, summary.folds[i].accuracy);
+  }
+  EXPECT_EQ(again.best_fold, summary.best_fold);
+}
+
+TEST(s21_model, hogwild_throughput) {
+  const std::string filename = "/tmp/s21_tests_throughput.csv";
+  {
+    std::ofstream file(filename);
+    for (int row = 0; row < 60; row++) {
+      file << row % 3 + 1;
+      for (int i = 0; i < s21::Image::kSizeInPx; i++)
+        file << ',' << (i % 3 == row % 3 ? 255 : 0);
+      file << '\n';
+    }
+  }
+  s21::Model model;
+  for (bool train : {true, false}) {
+    std::promise<void> loaded;
+    auto done = [&](std::string, std::size_t) { loaded.set_value(); };
+    if (train) {
+      model.SetTrainDataset(filename, done);
+    } else {
+      model.SetTestDataset(filename, done);
+    }
+    loaded.get_future().wait();
+  }
+  std::remove(filename.c_str());
+  std::remove(s21::DatasetCache::CachePath(filename).c_str());
+
+  s21::Configuration configuration;
+  configuration.SetNumberOfHiddenLayers(2);
+  configuration.SetEpochs(2);
+  configuration.SetThreads(3);
+  configuration.SetTrainMode(s21::TrainMode::kHogwild);
+  configuration.SetSaveWeightsEachEpoch(false);
+  model.SetConfiguration(configuration);
+
+  // Every worker reports once per epoch, from its own thread
+  std::mutex mutex;
+  std::vector<std::size_t> reports(3);
+  std::vector<double> rates;
+  std::promise<void> trained;
+  model.Train(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+              [&]() { trained.set_value(); },
+              [&](std::size_t worker, double samples_per_second) {
+                std::lock_guard<std::mutex> lock(mutex);
+                reports.at(worker)++;
+                rates.push_back(samples_per_second);
+              });
+  trained.get_future().wait();
+  EXPECT_EQ(reports, std::vector<std::size_t>({2, 2, 2}));
+  for (double rate : rates) EXPECT_GT(rate, 0);
+}
+
+TEST(s21_model, maps_version2_weights) {
+  const std::string filename = "/tmp/s21_tests_mapped_model.bin";
+  s21::NetworkSettings settings;
+  settings.number_of_hidden_layers = 1;
+  settings.neurons_in_hidden_layer = 16;
+  s21::NeuralNetwork source(s21::NetworkType::kMatrix, settings);
+  s21::WeightWriter::Write(filename, source.GetWeights(), settings);
+
+  auto is_mapped = [&filename]() {
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+      if (line.find(filename) != std::string::npos) return true;
+    }
+    return false;
+  };
+  std::vector<std::uint8_t> pixels(s21::Image::kSizeInPx, 100);
+  const char expected = static_cast<char>(
+      source.Predict(s21::ImageView(1, pixels.data(), pixels.size())).first +
+      'A');
+
+  // A matrix network in the stored precision runs on the mapping; any
+  // other configuration gets a copy of the weights
+  s21::Model model;
+  model.SetWeights(filename);
+  EXPECT_TRUE(is_mapped());
+  EXPECT_EQ(model.AnalyzeRawImage(pixels), expected);
+  EXPECT_EQ(model.GetWeights(), source.GetWeights());
+
+  s21::Configuration configuration;
+  configuration.SetNetworkType(s21::NetworkType::kGraph);
+  model.SetConfiguration(configuration);
+  model.SetWeights(filename);
+  EXPECT_FALSE(is_mapped());
+  EXPECT_EQ(model.AnalyzeRawImage(pixels), expected);
+  std::remove(filename.c_str());
+}
+
+TEST(s21_model, quantize_in_background) {
+  const std::string dataset = "/tmp/s21_tests_quantize.csv";
+  const std::string weights = "/tmp/s21_tests_quantize.bin";
+  const std::string int8 = "/tmp/s21_tests_quantize_int8.bin";
+  {
+    std::ofstream file(dataset);
+    for (int row = 0; row < 60; row++) {
+      file << row % 3 + 1;
+      for (int i = 0; i < s21::Image::kSizeInPx; i++)
+        file << ',' << (i % 3 == row % 3 ? 255 : 0);
+      file << '\n';
+    }
+  }
+  s21::NetworkSettings settings;
+  settings.number_of_hidden_layers = 1;
+  settings.neurons_in_hidden_layer = 16;
+  s21::NeuralNetwork source(s21::NetworkType::kMatrix, settings);
+  s21::WeightWriter::Write(weights, source.GetWeights(), settings, 3, 40);
+
+  s21::Model model;
+  std::size_t epoch = 0;
+  model.SetWeights(weights,
+                   [&](s21::NetworkSettings, std::size_t e, std::size_t) {
+                     epoch = e;
+                   });
+  EXPECT_EQ(epoch, 3u);
+  EXPECT_THROW(model.Quantize(int8, 30), std::runtime_error);
+
+  std::promise<void> loaded;
+  model.SetTestDataset(dataset,
+                       [&](std::string, std::size_t) { loaded.set_value(); });
+  loaded.get_future().wait();
+  std::remove(dataset.c_str());
+  std::remove(s21::DatasetCache::CachePath(dataset).c_str());
+
+  std::promise<std::pair<s21::NetworkTestMetrics, s21::NetworkTestMetrics>>
+      quantized;
+  model.Quantize(
+      int8, 30,
+      [&](s21::NetworkTestMetrics reference, s21::NetworkTestMetrics metrics) {
+        quantized.set_value({reference, metrics});
+      },
+      [&](const std::string& message) { ADD_FAILURE() << message; });
+  auto [reference, metrics] = quantized.get_future().get();
+  EXPECT_NEAR(metrics.accuracy, reference.accuracy, 0.1);
+
+  // The int8 file loads back through a single mapped WeightFile
+  std::size_t hidden = 0;
+  model.SetWeights(int8, [&](s21::NetworkSettings loaded_settings,
+                             std::size_t, std::size_t) {
+    hidden = loaded_settings.neurons_in_hidden_layer;
+  });
+  EXPECT_EQ(hidden, 16u);
+  std::remove(weights.c_str());
+  std::remove(int8.c_str());
+}
+
+TEST(s21_dataset, subset) {
+  s21::Dataset data(2, {1, 2, 3, 4, 5, 6}, {7, 8, 9});
+  EXPECT_EQ(data.size(), 3u);
+  EXPECT_EQ(data[1].GetNumber(), 8);
+  EXPECT_EQ(data[2].Pixels()[1], 6);
+
+  s21::Dataset subset = data.Subset({2, 0});
+  ASSERT_EQ(subset.size(), 2u);
+  EXPECT_EQ(subset[0].GetNumber(), 9);
+  EXPECT_EQ(subset[1].Pixels(), data[0].Pixels());
+  EXPECT_EQ(subset.Subset({1})[0].GetNumber(), 7);
+
+  int sum = 0;
+  for (s21::ImageView image : subset) sum += image.GetNumber();
+  EXPECT_EQ(sum, 16);
+  EXPECT_THROW(s21::Dataset(2, {1, 2, 3}, {1, 2}), std::logic_error);
+}
+
 int main(int argc, char* argv[]) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -103,6 +103,15 @@ void MainWindow::on_begin_test_button_clicked() {
             },
             Qt::QueuedConnection);
       },
+      [this](const CrossValidationMetrics &metrics) -> void {
+        QMetaObject::invokeMethod(
+            this,
+            [this, metrics]() {
+              std::invoke(&MainWindow::OnCrossValidationSummary, this,
+                          metrics);
+            },
+            Qt::QueuedConnection);
+      },
       [this](const std::string &message) -> void {
         QMetaObject::invokeMethod(
             this,
@@ -314,6 +323,15 @@ void MainWindow::on_begin_studying_box_clicked() {
             this, [this]() { std::invoke(&MainWindow::OnTrainEnd, this); },
             Qt::QueuedConnection);
       },
+      [this](std::size_t worker, double samples_per_second) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, worker, samples_per_second]() {
+              std::invoke(&MainWindow::OnTrainThroughput, this, worker,
+                          samples_per_second);
+            },
+            Qt::QueuedConnection);
+      },
       [this](const std::string &message) -> void {
         QMetaObject::invokeMethod(
             this,
@@ -392,6 +410,24 @@ void MainWindow::OnTestEnd(NetworkTestMetrics metrics) {
   TestUiUnlock();
 }
 
+// The labels show the kept network; the spread over the folds goes to the
+// status bar.
+void MainWindow::OnCrossValidationSummary(
+    const CrossValidationMetrics &metrics) {
+  QStringList folds;
+  for (const NetworkTestMetrics &fold : metrics.folds) {
+    folds << QString::number(fold.accuracy, 'f', 2);
+  }
+  statusBar()->showMessage(
+      tr("Точность %1 ± %2, F-мера %3 ± %4 по группам: %5 (лучшая %6)")
+          .arg(metrics.mean.accuracy, 0, 'f', 2)
+          .arg(metrics.stddev.accuracy, 0, 'f', 2)
+          .arg(metrics.mean.fscore, 0, 'f', 2)
+          .arg(metrics.stddev.fscore, 0, 'f', 2)
+          .arg(folds.join(", "))
+          .arg(metrics.best_fold + 1));
+}
+
 void MainWindow::OnTestError(const std::string &message) {
   ShowMessage(QMessageBox::Icon::Critical,
               QGuiApplication::applicationDisplayName(),
@@ -447,6 +483,13 @@ void MainWindow::OnTrainEnd() {
   TrainUiUnlock();
 }
 
+void MainWindow::OnTrainThroughput(std::size_t worker,
+                                   double samples_per_second) {
+  statusBar()->showMessage(tr("Поток %1: %2 изображений/с")
+                               .arg(worker + 1)
+                               .arg(samples_per_second, 0, 'f', 0));
+}
+
 void MainWindow::OnTrainError(const std::string &message) {
   ShowMessage(QMessageBox::Icon::Critical,
               QGuiApplication::applicationDisplayName(),
@@ -80,6 +80,7 @@ class MainWindow : public QMainWindow {
   void OnTestStart();
   void OnTestProgress(std::size_t progress);
   void OnTestEnd(NetworkTestMetrics metrics);
+  void OnCrossValidationSummary(const CrossValidationMetrics &metrics);
   void OnTestError(const std::string &message);
 
   void OnTrainStart();
@@ -89,6 +90,7 @@ class MainWindow : public QMainWindow {
   void OnTrainEpochTestProgress(std::size_t progress);
   void OnTrainEpochTestEnd(std::size_t accuracy, std::size_t epoch);
   void OnTrainEnd();
+  void OnTrainThroughput(std::size_t worker, double samples_per_second);
   void OnTrainError(const std::string &message);
 
   Ui::MainWindow *ui;
@@ -72,11 +72,11 @@ void ScribbleArea::update_image_info() {
   QImage image_ = image.scaled(s21::Image::kWidthInPx * coeff,
                                s21::Image::kHeightInPx * coeff,
                                Qt::KeepAspectRatio, Qt::SmoothTransformation);
-  std::vector<double> data(s21::Image::kSizeInPx);
+  std::vector<std::uint8_t> data(s21::Image::kSizeInPx);
   for (int i = 0; i < s21::Image::kHeightInPx; i++) {
     for (int j = 0; j < s21::Image::kWidthInPx; j++) {
       data[i * s21::Image::kHeightInPx + j] =
-          std::abs(image_.pixelColor(i, j).value() - 255);
+          static_cast<std::uint8_t>(255 - image_.pixelColor(i, j).value());
     }
   }
   if (!clean) {